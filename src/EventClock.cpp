@@ -0,0 +1,203 @@
+#include "EventClock.h"
+#include "TrafficManager.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Signal timers count in float; landing a hair past the threshold makes
+// sure the step that runs the event also sees it due
+static const double SIGNAL_SLACK = 1e-4;
+// Arrivals are stamped in whole nanoseconds; never poll the same instant twice
+static const double ARRIVAL_SLACK = 1e-6;
+
+static const char* const EVENT_NAMES[EventClock::EVENT_TYPE_COUNT] = {
+    "arrival", "poll", "spawn", "cycle", "signal", "reach"
+};
+
+EventClock::EventClock(double loadInterval, double spawnInterval, double cycleInterval)
+    : loadInterval(loadInterval), spawnInterval(spawnInterval), cycleInterval(cycleInterval),
+      simTime(0.0), startTime(0.0), cycleCount(0), source(nullptr), started(false),
+      generation(0), stepCount(0)
+{
+    std::fill(eventCounts, eventCounts + EVENT_TYPE_COUNT, 0LL);
+}
+
+void EventClock::setSource(VehicleSource* vehicleSource) {
+    source = vehicleSource;
+}
+
+void EventClock::resumeAt(double simSeconds) {
+    simTime = simSeconds;
+    startTime = simSeconds;
+}
+
+void EventClock::schedule(double time, EventType type) {
+    Event event;
+    event.time = time;
+    event.type = type;
+    event.generation = generation;
+    events.push(event);
+}
+
+// Straight to the next recorded arrival; sources that cannot tell are polled
+// every load interval like the lane files
+void EventClock::scheduleArrival() {
+    double next = source->nextArrivalTime();
+    if (next < 0.0) {
+        schedule(simTime + (loadInterval > 0.0 ? loadInterval : spawnInterval), EVENT_POLL);
+    }
+    else if (!std::isinf(next)) {
+        double earliest = stepCount > 0 ? simTime + ARRIVAL_SLACK : simTime;
+        schedule(std::max(next, earliest), EVENT_ARRIVAL);
+    }
+}
+
+void EventClock::scheduleStateEvents(TrafficManager& manager) {
+    double reach = manager.secondsUntilNextReach();
+    if (!std::isinf(reach)) {
+        schedule(simTime + reach, EVENT_REACH);
+    }
+
+    double signal = manager.secondsUntilSignalDue();
+    if (!std::isinf(signal)) {
+        schedule(simTime + signal + SIGNAL_SLACK, EVENT_SIGNAL);
+    }
+
+    // Spawns keep to the same ticks SimulationClock would use
+    if (manager.canSpawnQueued()) {
+        double ticks = std::floor((simTime - startTime) / spawnInterval + 1e-9) + 1.0;
+        schedule(startTime + ticks * spawnInterval, EVENT_SPAWN);
+    }
+}
+
+bool EventClock::isStale(const Event& event) const {
+    bool stateEvent = event.type == EVENT_SPAWN || event.type == EVENT_SIGNAL
+                   || event.type == EVENT_REACH;
+    return stateEvent && event.generation != generation;
+}
+
+void EventClock::advanceTo(TrafficManager& manager, double untilTime) {
+    if (!started) {
+        started = true;
+        if (source != nullptr) {
+            scheduleArrival();
+        }
+        else if (loadInterval > 0.0) {
+            schedule(simTime + loadInterval, EVENT_POLL);
+        }
+        if (!manager.isActuated()) {
+            schedule(simTime + cycleInterval, EVENT_CYCLE);
+        }
+        scheduleStateEvents(manager);
+    }
+
+    bool due[EVENT_TYPE_COUNT];
+    while (true) {
+        while (!events.empty() && isStale(events.top())) {
+            events.pop();
+        }
+        if (events.empty() || events.top().time > untilTime) {
+            break;
+        }
+
+        // Everything due at the same moment shares one step
+        double time = events.top().time;
+        std::fill(due, due + EVENT_TYPE_COUNT, false);
+        while (!events.empty() && events.top().time <= time) {
+            Event event = events.top();
+            events.pop();
+            if (!isStale(event)) {
+                due[event.type] = true;
+                eventCounts[event.type]++;
+            }
+        }
+        runStep(manager, time, due);
+    }
+
+    // Nothing happens before untilTime, so one step gets everybody there
+    if (untilTime > simTime) {
+        std::fill(due, due + EVENT_TYPE_COUNT, false);
+        runStep(manager, untilTime, due);
+    }
+}
+
+void EventClock::runStep(TrafficManager& manager, double time, const bool due[EVENT_TYPE_COUNT]) {
+    float deltaTime = static_cast<float>(time - simTime);
+    simTime = time;
+    stepCount++;
+
+    // Motion and signal timers over the gap bring the manager to this moment
+    manager.setSimTime(simTime);
+    manager.updateVehiclePositions(deltaTime);
+
+    bool greenChanged = manager.updateSignals(deltaTime);
+    if (manager.isActuated()) {
+        if (greenChanged) {
+            cycleCount++;
+        }
+    }
+    else if (due[EVENT_CYCLE]) {
+        cycleCount++;
+        manager.processCycle();
+        greenChanged = true;
+        schedule(simTime + cycleInterval, EVENT_CYCLE);
+    }
+
+    manager.cleanupInactiveVehicles();
+    if (greenChanged) {
+        // Cars now facing red count as stopped from the switch on, not from
+        // whenever the next event happens to be
+        manager.updateVehiclePositions(0.0f);
+        manager.cleanupInactiveVehicles();
+    }
+
+    if (due[EVENT_ARRIVAL] || due[EVENT_POLL]) {
+        if (source != nullptr) {
+            source->advanceTo(simTime);
+            manager.loadVehiclesFrom(*source);
+            scheduleArrival();
+        }
+        else {
+            manager.loadVehiclesFromFiles();
+            schedule(simTime + loadInterval, EVENT_POLL);
+        }
+    }
+    if (due[EVENT_SPAWN]) {
+        manager.spawnQueuedVehicles();
+    }
+
+    generation++;
+    scheduleStateEvents(manager);
+}
+
+double EventClock::getSimTime() const {
+    return simTime;
+}
+
+int EventClock::getCycleCount() const {
+    return cycleCount;
+}
+
+long long EventClock::getStepCount() const {
+    return stepCount;
+}
+
+long long EventClock::getEventCount(EventType type) const {
+    return eventCounts[type];
+}
+
+void EventClock::printStats() const {
+    std::cout << "\n--- Event engine ---" << std::endl;
+    std::cout << "Events:          ";
+    for (int type = 0; type < EVENT_TYPE_COUNT; type++) {
+        std::cout << " " << EVENT_NAMES[type] << " " << eventCounts[type];
+    }
+    std::cout << std::endl;
+
+    double minutes = (simTime - startTime) / 60.0;
+    std::cout << "Manager steps:    " << stepCount;
+    if (minutes > 0.0) {
+        std::cout << " (" << stepCount / minutes << " per simulated minute)";
+    }
+    std::cout << std::endl;
+}
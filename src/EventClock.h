@@ -0,0 +1,94 @@
+#ifndef EVENTCLOCK_H
+#define EVENTCLOCK_H
+
+#include <queue>
+#include <vector>
+
+class TrafficManager;
+class VehicleSource;
+
+// Drives a TrafficManager from one event to the next instead of on a fixed
+// timestep, so idle stretches cost nothing. Events wait in a priority queue
+// by simulated time:
+//   ARRIVAL  the source's next vehicle is due (TraceReplay knows when)
+//   POLL     lane files, or a live source, are read every load interval
+//   SPAWN    the next spawn tick while a queued vehicle has room
+//   CYCLE    fixed control moves the green on
+//   SIGNAL   a platoon release or an actuated max-out/gap-out is due
+//   REACH    a vehicle reaches its stop line, turn point or exit
+// Vehicles move in straight lines at constant speed between targets, so one
+// update over the whole gap moves them exactly as many small ones would.
+// SPAWN, SIGNAL and REACH depend on the state and are rescheduled after
+// every event; stale copies are skipped when they come up.
+//
+// Each event runs one manager step: motion and signal timers over the gap,
+// then the cycle, then cleanup, then loads and spawns at the event time.
+// Results match SimulationClock up to its timestep quantisation.
+class EventClock {
+public:
+    enum EventType {
+        EVENT_ARRIVAL,
+        EVENT_POLL,
+        EVENT_SPAWN,
+        EVENT_CYCLE,
+        EVENT_SIGNAL,
+        EVENT_REACH,
+        EVENT_TYPE_COUNT
+    };
+
+private:
+    struct Event {
+        double time;
+        EventType type;
+        long long generation;   // state-dependent events: the step that scheduled it
+
+        bool operator>(const Event& other) const {
+            return time > other.time || (time == other.time && type > other.type);
+        }
+    };
+
+    double loadInterval;
+    double spawnInterval;
+    double cycleInterval;
+
+    double simTime;
+    double startTime;
+    int cycleCount;
+    VehicleSource* source;
+    bool started;
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event> > events;
+    long long generation;
+    long long stepCount;
+    long long eventCounts[EVENT_TYPE_COUNT];
+
+    void schedule(double time, EventType type);
+    void scheduleArrival();
+    void scheduleStateEvents(TrafficManager& manager);
+    bool isStale(const Event& event) const;
+    void runStep(TrafficManager& manager, double time, const bool due[EVENT_TYPE_COUNT]);
+
+public:
+    EventClock(double loadInterval = 0.5, double spawnInterval = 0.1,
+               double cycleInterval = 5.0);
+
+    // Not owned; nullptr (the default) reads the lane files
+    void setSource(VehicleSource* vehicleSource);
+    // Runs every event up to and including untilTime, then moves the
+    // manager on to untilTime
+    void advanceTo(TrafficManager& manager, double untilTime);
+    // Continues from a restored manager's simulated time, before the first
+    // advanceTo()
+    void resumeAt(double simSeconds);
+
+    double getSimTime() const;
+    int getCycleCount() const;
+    // Manager steps run so far (events at the same time share one)
+    long long getStepCount() const;
+    long long getEventCount(EventType type) const;
+
+    // Events handled by type, and steps per simulated minute
+    void printStats() const;
+};
+
+#endif
@@ -2,13 +2,86 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <cstring>
 
-std::vector<Vehicle> FileReader::readLaneFile(const std::string& filename) {
-    std::vector<Vehicle> vehicles;
+VehicleRecordReader::VehicleRecordReader() : badHeader(false) {
+    header = VehicleFileHeader::make();
+}
+
+bool VehicleRecordReader::open(const std::string& filename) {
+    close();
+    badHeader = false;
+    file.open(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (file.gcount() != static_cast<std::streamsize>(sizeof(header))) {
+        close();
+        return false;
+    }
+    if (!header.isValid()) {
+        std::cerr << "Error: " << filename << " is not a supported vehicle record file" << std::endl;
+        badHeader = true;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool VehicleRecordReader::hasBadHeader() const {
+    return badHeader;
+}
+
+size_t VehicleRecordReader::read(VehicleRecord* out, size_t maxRecords) {
+    if (!file.is_open() || maxRecords == 0) {
+        return 0;
+    }
+
+    size_t recordSize = header.recordSize;
+    std::streamsize wanted = recordSize * maxRecords;
+    char* target = reinterpret_cast<char*>(out);
+    if (recordSize != sizeof(VehicleRecord)) {
+        scratch.resize(wanted);
+        target = scratch.data();
+    }
+
+    std::streampos start = file.tellg();
+    file.read(target, wanted);
+    size_t count = file.gcount() / recordSize;
+
+    // Step back over a partial record and clear EOF so the next call can
+    // pick it up once the writer has finished it
+    size_t consumed = count * recordSize;
+    file.clear();
+    file.seekg(start + static_cast<std::streamoff>(consumed));
+
+    if (recordSize != sizeof(VehicleRecord)) {
+        for (size_t i = 0; i < count; i++) {
+            std::memcpy(out + i, scratch.data() + i * recordSize, sizeof(VehicleRecord));
+        }
+    }
+    return count;
+}
+
+void VehicleRecordReader::close() {
+    if (file.is_open()) {
+        file.close();
+    }
+    file.clear();
+}
+
+const VehicleFileHeader& VehicleRecordReader::getHeader() const {
+    return header;
+}
+
+size_t FileReader::readLaneFile(const std::string& filename, std::vector<Vehicle>& out) {
+    size_t before = out.size();
     std::ifstream file(filename);
     
     if (!file.is_open()) {
-        return vehicles;  
+        return 0;  
     }
     
     std::string line;
@@ -25,13 +98,45 @@ std::vector<Vehicle> FileReader::readLaneFile(const std::string& filename) {
             
             
             if (lane >= 1 && lane <= 3) {
-                vehicles.push_back(Vehicle(plate, road, lane));
+                out.push_back(Vehicle(plate, road, lane));
             }
         }
     }
     
     file.close();
-    return vehicles;
+    return out.size() - before;
+}
+
+size_t FileReader::readBinaryLaneFile(const std::string& filename, std::vector<Vehicle>& out) {
+    size_t before = out.size();
+    VehicleRecordReader reader;
+    
+    if (!reader.open(filename)) {
+        // Records appended to a file truncated between the writer's header
+        // check and its write have no header; left alone the road would
+        // never be read again
+        if (reader.hasBadHeader()) {
+            std::ifstream file(filename, std::ios::binary | std::ios::ate);
+            long long lost = file.is_open() ? static_cast<long long>(file.tellg()) / sizeof(VehicleRecord) : 0;
+            file.close();
+            clearFile(filename);
+            std::cerr << "Discarded " << filename << " and about " << lost
+                      << " record(s) in it" << std::endl;
+        }
+        return 0;
+    }
+    
+    VehicleRecord chunk[1024];
+    size_t count;
+    while ((count = reader.read(chunk, 1024)) > 0) {
+        for (size_t i = 0; i < count; i++) {
+            if (chunk[i].isValid()) {
+                out.push_back(chunk[i].toVehicle());
+            }
+        }
+    }
+    
+    return out.size() - before;
 }
 
 void FileReader::clearFile(const std::string& filename) {
@@ -43,16 +148,19 @@ void FileReader::readAllLaneFiles(
     std::vector<Vehicle>& lane_A,
     std::vector<Vehicle>& lane_B,
     std::vector<Vehicle>& lane_C,
-    std::vector<Vehicle>& lane_D
+    std::vector<Vehicle>& lane_D,
+    LaneFileFormat format
 ) {
-    lane_A = readLaneFile("lane_A.txt");
-    lane_B = readLaneFile("lane_B.txt");
-    lane_C = readLaneFile("lane_C.txt");
-    lane_D = readLaneFile("lane_D.txt");
+    std::vector<Vehicle>* lanes[] = {&lane_A, &lane_B, &lane_C, &lane_D};
+    const char roads[] = {'A', 'B', 'C', 'D'};
     
-  
-    if (!lane_A.empty()) clearFile("lane_A.txt");
-    if (!lane_B.empty()) clearFile("lane_B.txt");
-    if (!lane_C.empty()) clearFile("lane_C.txt");
-    if (!lane_D.empty()) clearFile("lane_D.txt");
+    for (int i = 0; i < 4; i++) {
+        std::string filename = laneFileName(roads[i], format);
+        lanes[i]->clear();
+        size_t count = (format == LANE_FORMAT_BINARY) ? readBinaryLaneFile(filename, *lanes[i])
+                                                      : readLaneFile(filename, *lanes[i]);
+        
+        // An emptied binary file gets a fresh header from the next write
+        if (count > 0) clearFile(filename);
+    }
 }
\ No newline at end of file
@@ -3,23 +3,55 @@
 
 #include <string>
 #include <vector>
+#include <fstream>
 #include "Vehicle.h"
+#include "VehicleRecord.h"
+
+// Streams the records of a binary lane file in chunks; each chunk is a
+// straight copy from the file buffer, nothing is parsed
+class VehicleRecordReader {
+private:
+    std::ifstream file;
+    VehicleFileHeader header;
+    std::vector<char> scratch;    // only used when records are larger than ours
+    bool badHeader;
+
+public:
+    VehicleRecordReader();
+
+    // Fails on a missing file or an unknown/newer header
+    bool open(const std::string& filename);
+    // The last open() found a whole header that is not ours (a header still
+    // being written does not count)
+    bool hasBadHeader() const;
+    // Reads up to maxRecords; returns how many (0 at the end of the file).
+    // A record the writer has only half written yet is left for next time.
+    size_t read(VehicleRecord* out, size_t maxRecords);
+    void close();
+
+    const VehicleFileHeader& getHeader() const;
+};
 
 class FileReader {
 public:
     
-    static std::vector<Vehicle> readLaneFile(const std::string& filename);
+    // Append the file's vehicles to out and return how many, so a caller
+    // that keeps its vectors between polls does not allocate
+    static size_t readLaneFile(const std::string& filename, std::vector<Vehicle>& out);
+    static size_t readBinaryLaneFile(const std::string& filename, std::vector<Vehicle>& out);
     
   
     static void clearFile(const std::string& filename);
     
   
+    // Replaces the contents of the four vectors, reusing their capacity
     static void readAllLaneFiles(
         std::vector<Vehicle>& lane_A,
         std::vector<Vehicle>& lane_B,
         std::vector<Vehicle>& lane_C,
-        std::vector<Vehicle>& lane_D
+        std::vector<Vehicle>& lane_D,
+        LaneFileFormat format = LANE_FORMAT_TEXT
     );
 };
 
-#endif
\ No newline at end of file
+#endif
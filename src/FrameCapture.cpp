@@ -0,0 +1,179 @@
+#include "FrameCapture.h"
+#include <cstdio>
+#include <iostream>
+
+FrameCapture::FrameCapture(int maxQueuedFrames)
+    : width(0), height(0), stride(1),
+      poolSize(maxQueuedFrames > 0 ? maxQueuedFrames : 1),
+      pending(poolSize), recycled(poolSize), allocated(0), filling(nullptr),
+      stopRequested(false), running(false),
+      offered(0), queued(0), dropped(0), written(0), failed(0), bytesWritten(0)
+{
+}
+
+FrameCapture::~FrameCapture() {
+    stop();
+}
+
+void FrameCapture::setStride(int everyNth) {
+    stride = everyNth > 0 ? everyNth : 1;
+}
+
+bool FrameCapture::start(const std::string& filePrefix, int frameWidth, int frameHeight) {
+    if (running || frameWidth <= 0 || frameHeight <= 0) {
+        return false;
+    }
+
+    // Fail now rather than on the writer thread if the directory is missing
+    std::string probe = filePrefix + "probe.tmp";
+    FILE* file = std::fopen(probe.c_str(), "wb");
+    if (file == nullptr) {
+        std::cerr << "Cannot write frames to " << filePrefix << "*.ppm" << std::endl;
+        return false;
+    }
+    std::fclose(file);
+    std::remove(probe.c_str());
+
+    prefix = filePrefix;
+    width = frameWidth;
+    height = frameHeight;
+    startTime = std::chrono::steady_clock::now();
+    stopTime = startTime;
+    stopRequested.store(false);
+    writer = std::thread(&FrameCapture::run, this);
+    running = true;
+    return true;
+}
+
+void FrameCapture::stop() {
+    if (!running) {
+        return;
+    }
+    stopRequested.store(true);
+    writer.join();
+    stopTime = std::chrono::steady_clock::now();
+    running = false;
+}
+
+uint32_t* FrameCapture::beginFrame() {
+    if (!running) {
+        return nullptr;
+    }
+    if (offered++ % stride != 0) {
+        return nullptr;
+    }
+    long long number = queued + dropped;
+
+    recycled.drain([this](Frame&& frame) {
+        spare.push_back(std::move(frame));
+    });
+    if (spare.empty()) {
+        if (allocated == poolSize) {
+            dropped++;
+            return nullptr;
+        }
+        spare.push_back(Frame());
+        spare.back().pixels.resize(static_cast<size_t>(width) * height);
+        allocated++;
+    }
+
+    filling = &spare.back();
+    filling->number = number;
+    return filling->pixels.data();
+}
+
+void FrameCapture::commitFrame() {
+    if (filling == nullptr) {
+        return;
+    }
+    // Cannot fail: there are only poolSize buffers and the ring holds that many
+    pending.tryPush(std::move(*filling));
+    spare.pop_back();
+    filling = nullptr;
+    queued++;
+}
+
+void FrameCapture::abandonFrame() {
+    if (filling == nullptr) {
+        return;
+    }
+    filling = nullptr;   // the buffer stays spare
+    dropped++;
+}
+
+void FrameCapture::run() {
+    std::vector<unsigned char> row(static_cast<size_t>(width) * 3);
+    bool stopping = false;
+
+    while (true) {
+        // Read the flag before draining so frames queued before stop() are
+        // always written
+        stopping = stopRequested.load();
+        size_t taken = pending.drain([this, &row](Frame&& frame) {
+            if (writeFrame(frame, row)) {
+                written.fetch_add(1, std::memory_order_relaxed);
+            } else if (failed.fetch_add(1, std::memory_order_relaxed) == 0) {
+                std::cerr << "Failed to write frame " << frame.number << std::endl;
+            }
+            recycled.tryPush(std::move(frame));
+        });
+        if (taken == 0) {
+            if (stopping) {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+}
+
+bool FrameCapture::writeFrame(const Frame& frame, std::vector<unsigned char>& row) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%06lld.ppm", frame.number);
+    std::string path = prefix + name;
+
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    char header[32];
+    int headerBytes = std::snprintf(header, sizeof(header), "P6\n%d %d\n255\n", width, height);
+    bool ok = std::fwrite(header, 1, headerBytes, file) == static_cast<size_t>(headerBytes);
+
+    const uint32_t* pixel = frame.pixels.data();
+    for (int y = 0; y < height && ok; y++) {
+        unsigned char* out = row.data();
+        for (int x = 0; x < width; x++, pixel++) {
+            *out++ = static_cast<unsigned char>(*pixel >> 16);
+            *out++ = static_cast<unsigned char>(*pixel >> 8);
+            *out++ = static_cast<unsigned char>(*pixel);
+        }
+        ok = std::fwrite(row.data(), 1, row.size(), file) == row.size();
+    }
+
+    if (std::fclose(file) != 0) {
+        ok = false;
+    }
+    if (ok) {
+        bytesWritten.fetch_add(headerBytes + static_cast<long long>(row.size()) * height,
+                               std::memory_order_relaxed);
+    }
+    return ok;
+}
+
+void FrameCapture::printStats() const {
+    std::chrono::steady_clock::time_point end = running ? std::chrono::steady_clock::now() : stopTime;
+    double seconds = std::chrono::duration_cast<std::chrono::microseconds>(end - startTime).count()
+                     / 1000000.0;
+    if (seconds <= 0.0) seconds = 1e-6;
+
+    long long frames = written.load();
+    std::cout << "\n--- Frame Capture (" << width << "x" << height << ", queue " << poolSize
+              << " frames) ---" << std::endl;
+    std::cout << "Offered: " << offered << "  kept: " << queued + dropped
+              << "  written: " << frames << "  dropped: " << dropped
+              << "  failed: " << failed.load() << std::endl;
+    std::cout << "Capture: " << frames / seconds << " frames/s, "
+              << bytesWritten.load() / seconds / (1024.0 * 1024.0) << " MB/s to "
+              << prefix << "*.ppm" << std::endl;
+}
@@ -0,0 +1,91 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SpscRing.h"
+
+// Writes rendered frames to disk as a numbered PPM sequence
+// (<prefix>000000.ppm, ...) on a background thread. The drawing thread fills
+// one of a fixed pool of frame buffers and queues it through a lock-free
+// ring; the writer converts it to RGB, writes it and hands the buffer back
+// through a second ring. When every buffer is still waiting to be written
+// the frame is dropped rather than waiting for the disk, so capture never
+// slows the simulation or the window down. File numbers count every frame
+// kept by the stride, so drops show up as gaps in the sequence.
+class FrameCapture {
+private:
+    struct Frame {
+        long long number;
+        std::vector<uint32_t> pixels;   // 0xAARRGGBB, row by row
+    };
+
+    std::string prefix;
+    int width;
+    int height;
+    int stride;
+    int poolSize;
+
+    SpscRing<Frame> pending;     // drawing thread -> writer
+    SpscRing<Frame> recycled;    // writer -> drawing thread
+    std::vector<Frame> spare;    // drawing thread's free buffers
+    int allocated;
+    Frame* filling;
+
+    std::thread writer;
+    std::atomic<bool> stopRequested;
+    bool running;
+
+    // Drawing-thread counters
+    long long offered;
+    long long queued;
+    long long dropped;
+    // Writer counters
+    std::atomic<long long> written;
+    std::atomic<long long> failed;
+    std::atomic<long long> bytesWritten;
+    std::chrono::steady_clock::time_point startTime;
+    std::chrono::steady_clock::time_point stopTime;
+
+    void run();
+    bool writeFrame(const Frame& frame, std::vector<unsigned char>& row);
+
+    FrameCapture(const FrameCapture&);
+    FrameCapture& operator=(const FrameCapture&);
+
+public:
+    // At most maxQueuedFrames frames wait for the writer at any time
+    explicit FrameCapture(int maxQueuedFrames = 8);
+    ~FrameCapture();
+
+    // Keep only every n-th frame offered (1 = all)
+    void setStride(int everyNth);
+    // The directory part of prefix must exist
+    bool start(const std::string& filePrefix, int frameWidth, int frameHeight);
+    // Writes whatever is still queued and joins the writer
+    void stop();
+    bool isRunning() const { return running; }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Drawing side, once per frame: a width x height buffer to fill, or
+    // nullptr when this frame is skipped by the stride or dropped because
+    // the queue is full. Fill it, then commitFrame().
+    uint32_t* beginFrame();
+    void commitFrame();
+    // Counts a frame that could not be filled (e.g. read-back failed)
+    void abandonFrame();
+
+    long long getWrittenCount() const { return written.load(); }
+    long long getDroppedCount() const { return dropped; }
+
+    // Frames offered/written/dropped and the writer's frame rate
+    void printStats() const;
+};
+
+#endif
@@ -0,0 +1,132 @@
+#include "FrameProfiler.h"
+#include <algorithm>
+#include <iomanip>
+
+FrameProfiler::Scope::Scope(FrameProfiler& owner, FramePhase timedPhase)
+    : profiler(owner), phase(timedPhase) {
+    if (profiler.enabled) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+FrameProfiler::Scope::~Scope() {
+    if (profiler.enabled) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        profiler.addSample(phase, std::chrono::duration<float, std::micro>(elapsed).count());
+    }
+}
+
+FrameProfiler::FrameProfiler()
+    : enabled(false), sampleCount(0), nextSample(0), frameCount(0),
+      frameBudgetMicros(1000000.0f / 60.0f) {
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        current[p] = 0.0f;
+        totalMicros[p] = 0.0;
+        worstMicros[p] = 0.0f;
+        for (int i = 0; i < WINDOW; i++) {
+            samples[p][i] = 0.0f;
+        }
+    }
+}
+
+void FrameProfiler::setEnabled(bool on) {
+    enabled = on;
+}
+
+void FrameProfiler::setFrameBudget(float micros) {
+    frameBudgetMicros = micros;
+}
+
+float FrameProfiler::getFrameBudget() const {
+    return frameBudgetMicros;
+}
+
+void FrameProfiler::addSample(FramePhase phase, float micros) {
+    if (enabled) {
+        current[phase] += micros;
+    }
+}
+
+void FrameProfiler::endFrame() {
+    if (!enabled) {
+        return;
+    }
+
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        samples[p][nextSample] = current[p];
+        totalMicros[p] += current[p];
+        worstMicros[p] = std::max(worstMicros[p], current[p]);
+        current[p] = 0.0f;
+    }
+    nextSample = (nextSample + 1) % WINDOW;
+    sampleCount = std::min(sampleCount + 1, static_cast<int>(WINDOW));
+    frameCount++;
+}
+
+PhaseSummary FrameProfiler::summarize(FramePhase phase) const {
+    PhaseSummary summary = {0.0f, 0.0f, 0.0f, 0.0f};
+    if (sampleCount == 0) {
+        return summary;
+    }
+
+    // The ring is only full-length once WINDOW frames have passed; before
+    // that the filled part starts at index 0 either way
+    float sorted[WINDOW];
+    std::copy(samples[phase], samples[phase] + sampleCount, sorted);
+    std::sort(sorted, sorted + sampleCount);
+
+    float sum = 0.0f;
+    for (int i = 0; i < sampleCount; i++) {
+        sum += sorted[i];
+    }
+    int p99Index = std::min(sampleCount - 1, (sampleCount * 99 + 99) / 100 - 1);
+
+    summary.minMicros = sorted[0];
+    summary.avgMicros = sum / sampleCount;
+    summary.maxMicros = sorted[sampleCount - 1];
+    summary.p99Micros = sorted[p99Index];
+    return summary;
+}
+
+long long FrameProfiler::getFrameCount() const {
+    return frameCount;
+}
+
+const char* FrameProfiler::phaseName(FramePhase phase) {
+    switch (phase) {
+        case PHASE_LOAD: return "load";
+        case PHASE_SPAWN: return "spawn";
+        case PHASE_UPDATE: return "update";
+        case PHASE_SIGNALS: return "signals";
+        case PHASE_CLEANUP: return "cleanup";
+        case PHASE_STEP: return "step";
+        case PHASE_RENDER: return "render";
+        case PHASE_FRAME: return "frame";
+        default: return "?";
+    }
+}
+
+void FrameProfiler::report(std::ostream& out) const {
+    std::ios::fmtflags oldFlags = out.flags();
+    std::streamsize oldPrecision = out.precision();
+    out << std::fixed << std::setprecision(1);
+
+    out << "\n--- Frame phases (us, last " << sampleCount << " of " << frameCount << " frames) ---\n";
+    out << "Phase          min      avg      p99      max   run avg    worst\n";
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        FramePhase phase = static_cast<FramePhase>(p);
+        PhaseSummary summary = summarize(phase);
+        double runAverage = frameCount > 0 ? totalMicros[p] / frameCount : 0.0;
+        out << std::left << std::setw(8) << phaseName(phase) << std::right
+            << std::setw(9) << summary.minMicros
+            << std::setw(9) << summary.avgMicros
+            << std::setw(9) << summary.p99Micros
+            << std::setw(9) << summary.maxMicros
+            << std::setw(10) << runAverage
+            << std::setw(9) << worstMicros[p] << "\n";
+    }
+    out.flush();
+
+    out.flags(oldFlags);
+    out.precision(oldPrecision);
+}
@@ -0,0 +1,86 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <chrono>
+#include <ostream>
+
+// The phases of one simulator_sdl frame, in the order they run
+enum FramePhase {
+    PHASE_LOAD,
+    PHASE_SPAWN,
+    PHASE_UPDATE,
+    PHASE_SIGNALS,
+    PHASE_CLEANUP,
+    PHASE_STEP,       // a whole simulation step on the simulation thread
+    PHASE_RENDER,
+    PHASE_FRAME,      // the whole frame before the sleep
+    PHASE_COUNT
+};
+
+// Rolling figures of one phase over the last WINDOW frames, in microseconds
+struct PhaseSummary {
+    float minMicros;
+    float avgMicros;
+    float maxMicros;
+    float p99Micros;
+};
+
+// Per-phase frame timer. Each frame the time spent in every phase is summed
+// (a phase that did not run this frame counts as 0) and kept in a ring of
+// the last WINDOW frames, from which min/avg/max/p99 are taken on demand.
+// Run-long totals and the worst frame are kept as well for the exit report.
+// A disabled profiler never reads the clock, so the scopes can stay in the
+// frame loop for good.
+class FrameProfiler {
+public:
+    enum { WINDOW = 120 };   // two seconds at 60 FPS
+
+    // Times one phase from construction to destruction
+    class Scope {
+    private:
+        FrameProfiler& profiler;
+        FramePhase phase;
+        std::chrono::steady_clock::time_point start;
+
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+
+    public:
+        Scope(FrameProfiler& owner, FramePhase timedPhase);
+        ~Scope();
+    };
+
+private:
+    bool enabled;
+    float current[PHASE_COUNT];
+    float samples[PHASE_COUNT][WINDOW];
+    int sampleCount;
+    int nextSample;
+    long long frameCount;
+    double totalMicros[PHASE_COUNT];
+    float worstMicros[PHASE_COUNT];
+    float frameBudgetMicros;
+
+public:
+    FrameProfiler();
+
+    void setEnabled(bool on);
+    bool isEnabled() const { return enabled; }
+    // Frame time the overlay scales its bars to (default 1/60 s)
+    void setFrameBudget(float micros);
+    float getFrameBudget() const;
+
+    void addSample(FramePhase phase, float micros);
+    // Closes the current frame: its per-phase sums join the window
+    void endFrame();
+
+    PhaseSummary summarize(FramePhase phase) const;
+    long long getFrameCount() const;
+
+    static const char* phaseName(FramePhase phase);
+
+    // Table of every phase: window min/avg/p99/max and run average/worst
+    void report(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "GridNetwork.h"
+#include <cstdio>
+
+GridNetwork::GridNetwork(int rows, int cols, int threadCount, double arrivalRate,
+                         unsigned seed, double cycleInterval, double spawnInterval)
+    : rows(rows), cols(cols),
+      junctions(rows * cols),
+      clocks(rows * cols, SimulationClock(0.0, spawnInterval, cycleInterval)),
+      pool(threadCount),
+      arrivalRate(arrivalRate),
+      randomEngine(seed),
+      injectedCount(0), handedOffCount(0), leftNetworkCount(0)
+{
+    for (auto& junction : junctions) {
+        junction.setVerbose(false);
+        junction.setCollectExits(true);
+    }
+}
+
+void GridNetwork::setMaxActivePerRoad(int maxActive) {
+    for (auto& junction : junctions) {
+        junction.setMaxActivePerRoad(maxActive);
+    }
+}
+
+void GridNetwork::setSignalControl(SignalControl mode, const ActuatedTiming& timing) {
+    for (auto& junction : junctions) {
+        junction.setSignalControl(mode, timing);
+    }
+}
+
+void GridNetwork::setDischarge(DischargeMode mode, const DischargeTiming& timing) {
+    for (auto& junction : junctions) {
+        junction.setDischarge(mode, timing);
+    }
+}
+
+// Same lane split as TrafficGenerator: 20% right, 60% straight, 20% left
+int GridNetwork::selectLane() {
+    int random = randomEngine() % 100;
+    if (random < 20) return 1;
+    if (random < 80) return 2;
+    return 3;
+}
+
+void GridNetwork::step(float deltaTime) {
+    // Junctions only touch their own state while stepping
+    pool.parallelFor(rows * cols, [this, deltaTime](int i) {
+        clocks[i].step(junctions[i], deltaTime);
+    });
+
+    handoff();
+    injectArrivals(deltaTime);
+}
+
+void GridNetwork::handoff() {
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            junctions[indexOf(row, col)].takeExitedVehicles(exitBuffer);
+
+            for (const auto& exited : exitBuffer) {
+                int nextRow = row;
+                int nextCol = col;
+                switch (exited.nextRoad) {
+                    case 'A': nextCol++; break;   // heading right
+                    case 'B': nextRow++; break;   // heading down
+                    case 'C': nextCol--; break;   // heading left
+                    case 'D': nextRow--; break;   // heading up
+                }
+
+                if (nextRow < 0 || nextRow >= rows || nextCol < 0 || nextCol >= cols) {
+                    PlateRegistry::release(exited.vehicle.getPlateId());
+                    leftNetworkCount++;
+                    continue;
+                }
+
+                junctions[indexOf(nextRow, nextCol)].addVehicle(
+                    Vehicle(exited.vehicle.getPlateId(), exited.nextRoad, selectLane()));
+                handedOffCount++;
+            }
+        }
+    }
+}
+
+void GridNetwork::injectArrivals(float deltaTime) {
+    if (arrivalRate <= 0.0) return;
+
+    std::poisson_distribution<int> arrivals(arrivalRate * deltaTime);
+
+    auto inject = [this, &arrivals](int row, int col, char road) {
+        int count = arrivals(randomEngine);
+        for (int i = 0; i < count; i++) {
+            injectedCount++;
+            char plate[24];
+            int length = std::snprintf(plate, sizeof(plate), "GR%lld", injectedCount);
+            junctions[indexOf(row, col)].addVehicle(
+                Vehicle(PlateRegistry::intern(plate, length), road, selectLane()));
+        }
+    };
+
+    // Every approach that comes from outside the grid gets its own stream
+    for (int row = 0; row < rows; row++) {
+        inject(row, 0, 'A');
+        inject(row, cols - 1, 'C');
+    }
+    for (int col = 0; col < cols; col++) {
+        inject(0, col, 'B');
+        inject(rows - 1, col, 'D');
+    }
+}
+
+int GridNetwork::getJunctionCount() const {
+    return rows * cols;
+}
+
+int GridNetwork::getThreadCount() const {
+    return pool.getThreadCount();
+}
+
+const TrafficManager& GridNetwork::getJunction(int row, int col) const {
+    return junctions[indexOf(row, col)];
+}
+
+long long GridNetwork::getInjectedCount() const {
+    return injectedCount;
+}
+
+long long GridNetwork::getHandedOffCount() const {
+    return handedOffCount;
+}
+
+long long GridNetwork::getLeftNetworkCount() const {
+    return leftNetworkCount;
+}
+
+long long GridNetwork::getTotalProcessed() const {
+    long long total = 0;
+    for (const auto& junction : junctions) {
+        total += junction.getTotalProcessed();
+    }
+    return total;
+}
+
+long long GridNetwork::getVehiclesInNetwork() const {
+    long long total = 0;
+    for (const auto& junction : junctions) {
+        total += junction.getLaneSize('A') + junction.getLaneSize('B')
+               + junction.getLaneSize('C') + junction.getLaneSize('D');
+    }
+    return total;
+}
@@ -0,0 +1,59 @@
+#ifndef GRIDNETWORK_H
+#define GRIDNETWORK_H
+
+#include <vector>
+#include <random>
+#include "TrafficManager.h"
+#include "SimulationClock.h"
+#include "ThreadPool.h"
+
+// Rows x columns of signalized junctions, each its own TrafficManager.
+// Every tick the junctions are stepped in parallel on the thread pool, then
+// a serial handoff phase moves the vehicles that left one junction onto the
+// matching inbound road of its neighbour and injects new arrivals at the
+// edges of the grid. The handoff runs in a fixed order with a seeded
+// generator, so results do not depend on the number of threads.
+// Injected vehicles get their own plates (GR1, GR2, ...), which are
+// released from PlateRegistry when the vehicle leaves the grid, so the
+// plate table holds only the vehicles still inside.
+class GridNetwork {
+private:
+    int rows;
+    int cols;
+    std::vector<TrafficManager> junctions;
+    std::vector<SimulationClock> clocks;
+    ThreadPool pool;
+
+    double arrivalRate;     // vehicles per second per boundary approach
+    std::mt19937 randomEngine;
+    std::vector<ExitedVehicle> exitBuffer;
+
+    long long injectedCount;
+    long long handedOffCount;
+    long long leftNetworkCount;
+
+    int indexOf(int row, int col) const { return row * cols + col; }
+    int selectLane();
+    void handoff();
+    void injectArrivals(float deltaTime);
+
+public:
+    GridNetwork(int rows, int cols, int threadCount, double arrivalRate,
+                unsigned seed, double cycleInterval = 5.0, double spawnInterval = 0.1);
+
+    void setMaxActivePerRoad(int maxActive);
+    void setSignalControl(SignalControl mode, const ActuatedTiming& timing = ActuatedTiming());
+    void setDischarge(DischargeMode mode, const DischargeTiming& timing = DischargeTiming());
+    void step(float deltaTime);
+
+    int getJunctionCount() const;
+    int getThreadCount() const;
+    const TrafficManager& getJunction(int row, int col) const;
+    long long getInjectedCount() const;
+    long long getHandedOffCount() const;
+    long long getLeftNetworkCount() const;
+    long long getTotalProcessed() const;
+    long long getVehiclesInNetwork() const;
+};
+
+#endif
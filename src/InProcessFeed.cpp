@@ -0,0 +1,115 @@
+#include "InProcessFeed.h"
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+InProcessFeed::InProcessFeed(size_t capacityPerRoad)
+    : channelA(capacityPerRoad), channelB(capacityPerRoad),
+      channelC(capacityPerRoad), channelD(capacityPerRoad),
+      closed(false), startTime(std::chrono::steady_clock::now())
+{
+}
+
+InProcessFeed::RoadChannel* InProcessFeed::getChannel(char road) {
+    switch(road) {
+        case 'A': return &channelA;
+        case 'B': return &channelB;
+        case 'C': return &channelC;
+        case 'D': return &channelD;
+        default: return nullptr;
+    }
+}
+
+bool InProcessFeed::publish(const std::string& plate, char road, int lane) {
+    RoadChannel* channel = getChannel(road);
+    if (channel == nullptr) {
+        return false;
+    }
+
+    VehicleRecord record = VehicleRecord::make(plate, road, lane, 0);
+    int spins = 0;
+    while (!channel->ring.tryPush(std::move(record))) {
+        if (closed.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (spins == 0) {
+            channel->fullWaits.fetch_add(1, std::memory_order_relaxed);
+        }
+        // Back off gently: the consumer only drains once per load step
+        if (++spins < 64) {
+            continue;
+        }
+        std::this_thread::yield();
+    }
+
+    channel->published.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void InProcessFeed::drainChannel(RoadChannel& channel, std::vector<Vehicle>& out) {
+    size_t occupancy = channel.ring.size();
+    if (occupancy > channel.maxOccupancy) {
+        channel.maxOccupancy = occupancy;
+    }
+    channel.occupancySum += occupancy;
+    channel.occupancySamples++;
+
+    channel.drained += channel.ring.drain([&out](VehicleRecord&& record) {
+        out.push_back(record.toVehicle());
+    });
+}
+
+int InProcessFeed::poll(
+    std::vector<Vehicle>& lane_A,
+    std::vector<Vehicle>& lane_B,
+    std::vector<Vehicle>& lane_C,
+    std::vector<Vehicle>& lane_D
+) {
+    size_t before = lane_A.size() + lane_B.size() + lane_C.size() + lane_D.size();
+    drainChannel(channelA, lane_A);
+    drainChannel(channelB, lane_B);
+    drainChannel(channelC, lane_C);
+    drainChannel(channelD, lane_D);
+    return lane_A.size() + lane_B.size() + lane_C.size() + lane_D.size() - before;
+}
+
+void InProcessFeed::close() {
+    closed.store(true);
+}
+
+void InProcessFeed::printStats() const {
+    double seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime
+    ).count() / 1000000.0;
+    if (seconds <= 0.0) seconds = 1e-6;
+
+    const RoadChannel* channels[] = {&channelA, &channelB, &channelC, &channelD};
+    const char roads[] = {'A', 'B', 'C', 'D'};
+
+    long long totalPublished = 0;
+    long long totalDrained = 0;
+    std::streamsize oldPrecision = std::cout.precision();
+
+    std::cout << "\n--- In-Process Feed (ring capacity " << channelA.ring.getCapacity()
+              << " per road) ---" << std::endl;
+    std::cout << "Road  published    drained  full-waits  max-occ  avg-occ" << std::endl;
+    for (int i = 0; i < 4; i++) {
+        const RoadChannel& c = *channels[i];
+        long long published = c.published.load();
+        totalPublished += published;
+        totalDrained += c.drained;
+        double avgOccupancy = c.occupancySamples ? c.occupancySum / c.occupancySamples : 0.0;
+
+        std::cout << "  " << roads[i]
+                  << std::setw(11) << published
+                  << std::setw(11) << c.drained
+                  << std::setw(12) << c.fullWaits.load()
+                  << std::setw(9) << c.maxOccupancy
+                  << std::setw(9) << std::fixed << std::setprecision(1) << avgOccupancy
+                  << std::endl;
+    }
+    std::cout.unsetf(std::ios::fixed);
+    std::cout.precision(oldPrecision);
+    std::cout << "Producer: " << totalPublished / seconds << " vehicles/s" << std::endl;
+    std::cout << "Consumer: " << totalDrained / seconds << " vehicles/s" << std::endl;
+}
@@ -0,0 +1,63 @@
+#ifndef INPROCESSFEED_H
+#define INPROCESSFEED_H
+
+#include <atomic>
+#include <chrono>
+#include "VehicleFeed.h"
+#include "SpscRing.h"
+#include "VehicleRecord.h"
+
+// Connects a TrafficGenerator running on its own thread to the simulator in
+// the same process: one lock-free single-producer/single-consumer ring per
+// road. The generator thread publishes, the simulation thread polls once per
+// load step, and the ring itself takes no lock and makes no syscall. The
+// rings carry VehicleRecords, so plates are interned in PlateRegistry on
+// the simulation thread as they are drained, never by the producer.
+class InProcessFeed : public VehicleSink, public VehicleSource {
+private:
+    struct RoadChannel {
+        SpscRing<VehicleRecord> ring;
+        std::atomic<long long> published;  // producer-side counters
+        std::atomic<long long> fullWaits;
+        long long drained;                 // consumer-side counters
+        size_t maxOccupancy;
+        double occupancySum;
+        long long occupancySamples;
+
+        explicit RoadChannel(size_t capacity)
+            : ring(capacity), published(0), fullWaits(0), drained(0),
+              maxOccupancy(0), occupancySum(0.0), occupancySamples(0) {}
+    };
+
+    RoadChannel channelA;
+    RoadChannel channelB;
+    RoadChannel channelC;
+    RoadChannel channelD;
+    std::atomic<bool> closed;
+    std::chrono::steady_clock::time_point startTime;
+
+    RoadChannel* getChannel(char road);
+    static void drainChannel(RoadChannel& channel, std::vector<Vehicle>& out);
+
+public:
+    explicit InProcessFeed(size_t capacityPerRoad = 4096);
+
+    // Producer side: blocks (spinning, then yielding) while the road's ring
+    // is full, so no arrival is ever dropped
+    bool publish(const std::string& plate, char road, int lane);
+
+    // Consumer side
+    int poll(
+        std::vector<Vehicle>& lane_A,
+        std::vector<Vehicle>& lane_B,
+        std::vector<Vehicle>& lane_C,
+        std::vector<Vehicle>& lane_D
+    );
+
+    // Unblocks a producer waiting on a full ring (used at shutdown)
+    void close();
+
+    void printStats() const;
+};
+
+#endif
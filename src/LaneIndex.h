@@ -0,0 +1,98 @@
+#ifndef LANEINDEX_H
+#define LANEINDEX_H
+
+#include <deque>
+#include <vector>
+
+// Vehicles still approaching the stop line in one lane of one road, ordered
+// front (nearest the stop line) to back. Entries are indices into the road's
+// active vehicle arrays. Cars in a lane cannot overtake, so they join at the
+// back and leave from the front; each one keeps the sequence number it was
+// given on push, which makes finding its leader a single lookup.
+class LaneIndex {
+private:
+    std::deque<int> order;     // -1 marks a vehicle that left out of turn
+    long long headSequence;    // sequence number of order.front()
+    int liveCount;
+
+    void dropLeadingGaps() {
+        while (!order.empty() && order.front() < 0) {
+            order.pop_front();
+            headSequence++;
+        }
+    }
+
+public:
+    LaneIndex() : headSequence(0), liveCount(0) {}
+
+    // Adds a vehicle at the back and returns its sequence number
+    long long push(int vehicleIndex) {
+        order.push_back(vehicleIndex);
+        liveCount++;
+        return headSequence + order.size() - 1;
+    }
+
+    // Removes the vehicle with the given sequence number. That is the head
+    // in practice; anyone else leaves a gap so the sequence numbers of the
+    // vehicles around it stay valid.
+    void remove(long long sequence) {
+        long long offset = sequence - headSequence;
+        if (offset < 0 || offset >= static_cast<long long>(order.size())) return;
+        if (order[offset] < 0) return;
+
+        order[offset] = -1;
+        liveCount--;
+        dropLeadingGaps();
+    }
+
+    bool empty() const { return liveCount == 0; }
+    int size() const { return liveCount; }
+    int front() const { return order.empty() ? -1 : order.front(); }
+
+    // Index of the vehicle directly ahead, or -1 for the head of the lane
+    int leaderOf(long long sequence) const {
+        long long offset = sequence - headSequence;
+        if (offset > static_cast<long long>(order.size())) {
+            offset = order.size();
+        }
+        for (long long i = offset - 1; i >= 0; i--) {
+            if (order[i] >= 0) return order[i];
+        }
+        return -1;
+    }
+
+    // Index of the last vehicle in the lane, or -1 when it is empty
+    int back() const {
+        return leaderOf(headSequence + order.size());
+    }
+
+    // Rewrites indices after the road's arrays were compacted
+    void remap(const std::vector<int>& newIndex) {
+        for (auto& index : order) {
+            if (index >= 0) index = newIndex[index];
+        }
+    }
+
+    // Raw contents for TrafficManager snapshots: the sequence number of the
+    // first slot and every slot front to back, gaps (-1) included
+    long long getHeadSequence() const { return headSequence; }
+    int slotCount() const { return static_cast<int>(order.size()); }
+    int slotAt(int i) const { return order[i]; }
+    void assign(long long head, const std::vector<int>& slots) {
+        order.assign(slots.begin(), slots.end());
+        headSequence = head;
+        liveCount = 0;
+        for (int index : slots) {
+            if (index >= 0) liveCount++;
+        }
+        dropLeadingGaps();
+    }
+
+    void clear() {
+        headSequence += order.size();
+        order.clear();
+        liveCount = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,501 @@
+#include "LaneLog.h"
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define LANE_LOG_SUPPORTED 1
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#define LANE_LOG_INOTIFY 1
+#endif
+
+static const char ROADS[] = {'A', 'B', 'C', 'D'};
+static const long long HEADER_BYTES = sizeof(VehicleFileHeader);
+
+static int roadIndexOf(char road) {
+    return (road >= 'A' && road <= 'D') ? road - 'A' : -1;
+}
+
+std::string laneSegmentName(const std::string& directory, char road, unsigned long long segment) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "lane_%c.%06llu.log", road, segment);
+    return directory + "/" + name;
+}
+
+static std::string cursorName(const std::string& directory, char road) {
+    return directory + "/lane_" + road + ".cursor";
+}
+
+#ifdef LANE_LOG_INOTIFY
+// True for "lane_X.<segment>.log" with a known road. The reader's own cursor
+// saves and the writer's ".tmp" files share the prefix and must not count.
+static bool isLogName(const char* name) {
+    size_t length = std::strlen(name);
+    return length > 10 && std::strncmp(name, "lane_", 5) == 0 && roadIndexOf(name[5]) >= 0
+        && std::strcmp(name + length - 4, ".log") == 0;
+}
+#endif
+
+#ifdef LANE_LOG_SUPPORTED
+
+// Lowest and highest segment numbers present for a road (0 when none)
+static void findSegments(const std::string& directory, char road,
+                         unsigned long long& lowest, unsigned long long& highest) {
+    lowest = 0;
+    highest = 0;
+
+    DIR* dir = opendir(directory.c_str());
+    if (dir == nullptr) return;
+
+    char prefix[8];
+    std::snprintf(prefix, sizeof(prefix), "lane_%c.", road);
+
+    while (struct dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (std::strncmp(name, prefix, 7) != 0) continue;
+
+        char* end = nullptr;
+        unsigned long long segment = std::strtoull(name + 7, &end, 10);
+        if (end == name + 7 || std::strcmp(end, ".log") != 0 || segment == 0) continue;
+
+        if (lowest == 0 || segment < lowest) lowest = segment;
+        if (segment > highest) highest = segment;
+    }
+    closedir(dir);
+}
+
+static bool writeFully(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, bytes, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        bytes += written;
+        size -= written;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------- writer
+
+LaneLogWriter::LaneLogWriter(long long maxSegmentBytes)
+    : maxSegmentBytes(maxSegmentBytes), rotations(0)
+{
+}
+
+LaneLogWriter::~LaneLogWriter() {
+    close();
+}
+
+bool LaneLogWriter::open(const std::string& logDirectory) {
+    close();
+    directory = logDirectory;
+
+    for (int i = 0; i < 4; i++) {
+        unsigned long long lowest, highest;
+        findSegments(directory, ROADS[i], lowest, highest);
+
+        bool ok = (highest > 0) ? openSegment(i, highest, false)
+                                : openSegment(i, 1, true);
+        if (!ok) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LaneLogWriter::openSegment(int roadIndex, unsigned long long segment, bool create) {
+    RoadLog& road = roads[roadIndex];
+    std::string name = laneSegmentName(directory, ROADS[roadIndex], segment);
+    int fd;
+
+    if (create) {
+        // Build the segment under a temporary name and rename it into place,
+        // so readers never see a segment without its header
+        std::string temporary = name + ".tmp";
+        fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (fd < 0) {
+            std::cerr << "Error: Could not create " << temporary << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+
+        VehicleFileHeader header = VehicleFileHeader::make();
+        if (!writeFully(fd, &header, sizeof(header)) || std::rename(temporary.c_str(), name.c_str()) != 0) {
+            std::cerr << "Error: Could not start segment " << name << ": " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            ::unlink(temporary.c_str());
+            return false;
+        }
+    }
+    else {
+        fd = ::open(name.c_str(), O_WRONLY | O_APPEND);
+        if (fd < 0) {
+            std::cerr << "Error: Could not open " << name << ": " << std::strerror(errno) << std::endl;
+            return false;
+        }
+    }
+
+    struct stat info;
+    long long size = (fstat(fd, &info) == 0) ? info.st_size : HEADER_BYTES;
+
+    // Drop a record torn by a writer that died mid-write
+    long long tail = (size - HEADER_BYTES) % static_cast<long long>(sizeof(VehicleRecord));
+    if (!create && size > HEADER_BYTES && tail != 0 && ftruncate(fd, size - tail) == 0) {
+        size -= tail;
+    }
+
+    if (road.fd >= 0) {
+        ::close(road.fd);
+    }
+    road.fd = fd;
+    road.segment = segment;
+    road.size = size;
+    return true;
+}
+
+void LaneLogWriter::close() {
+    for (int i = 0; i < 4; i++) {
+        if (roads[i].fd >= 0) {
+            flushRoad(i);
+            ::close(roads[i].fd);
+        }
+        roads[i] = RoadLog();
+    }
+}
+
+bool LaneLogWriter::publish(const std::string& plate, char road, int lane) {
+    return publishRecord(VehicleRecord::make(plate, road, lane, epochNanoseconds()));
+}
+
+bool LaneLogWriter::publishRecord(const VehicleRecord& record) {
+    int index = roadIndexOf(record.road);
+    if (index < 0 || roads[index].fd < 0) {
+        return false;
+    }
+    RoadLog& road = roads[index];
+
+    // Everything for the old segment is written before the next one
+    // appears, since its appearance is what tells readers it is sealed
+    if (road.size > HEADER_BYTES
+        && road.size + static_cast<long long>(sizeof(record)) > maxSegmentBytes) {
+        if (!flushRoad(index) || !openSegment(index, road.segment + 1, true)) {
+            return false;
+        }
+        rotations++;
+    }
+
+    const char* bytes = reinterpret_cast<const char*>(&record);
+    road.pending.insert(road.pending.end(), bytes, bytes + sizeof(record));
+    road.size += sizeof(record);
+
+    if (road.pending.size() >= 64 * 1024) {
+        return flushRoad(index);
+    }
+    return true;
+}
+
+bool LaneLogWriter::flushRoad(int roadIndex) {
+    RoadLog& road = roads[roadIndex];
+    if (road.pending.empty()) return true;
+
+    bool written = writeFully(road.fd, road.pending.data(), road.pending.size());
+    if (!written) {
+        std::cerr << "Error: Could not append to lane " << ROADS[roadIndex] << " log: "
+                  << std::strerror(errno) << std::endl;
+        road.size -= road.pending.size();
+    }
+    road.pending.clear();
+    return written;
+}
+
+void LaneLogWriter::flush() {
+    for (int i = 0; i < 4; i++) {
+        if (roads[i].fd >= 0) {
+            flushRoad(i);
+        }
+    }
+}
+
+long long LaneLogWriter::getRotations() const {
+    return rotations;
+}
+
+// ---------------------------------------------------------------- reader
+
+LaneLogReader::LaneLogReader()
+    : inotifyFd(-1), opened(false), chunk(4096),
+      receivedCount(0), pollCount(0), idlePolls(0), segmentsFinished(0), bytesRead(0)
+{
+}
+
+LaneLogReader::~LaneLogReader() {
+    close();
+}
+
+bool LaneLogReader::open(const std::string& logDirectory) {
+    close();
+    directory = logDirectory;
+
+    struct stat info;
+    if (stat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+        std::cerr << "Error: lane log directory " << directory << " does not exist" << std::endl;
+        return false;
+    }
+
+#ifdef LANE_LOG_INOTIFY
+    // Watch before the first read so nothing appended in between is missed
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0
+        && inotify_add_watch(inotifyFd, directory.c_str(), IN_MODIFY | IN_CREATE | IN_MOVED_TO) < 0) {
+        ::close(inotifyFd);
+        inotifyFd = -1;
+    }
+#endif
+
+    for (int i = 0; i < 4; i++) {
+        RoadCursor& road = roads[i];
+        road.cursorFd = ::open(cursorName(directory, ROADS[i]).c_str(), O_RDWR | O_CREAT, 0644);
+
+        uint64_t saved[2] = {0, 0};
+        if (road.cursorFd >= 0 && pread(road.cursorFd, saved, sizeof(saved), 0) == sizeof(saved)
+            && openSegment(road, ROADS[i], saved[0], static_cast<long long>(saved[1]))) {
+            continue;
+        }
+
+        unsigned long long lowest, highest;
+        findSegments(directory, ROADS[i], lowest, highest);
+        if (lowest > 0) {
+            openSegment(road, ROADS[i], lowest, HEADER_BYTES);
+        }
+    }
+
+    opened = true;
+    return true;
+}
+
+void LaneLogReader::close() {
+    for (int i = 0; i < 4; i++) {
+        if (roads[i].fd >= 0) ::close(roads[i].fd);
+        if (roads[i].cursorFd >= 0) ::close(roads[i].cursorFd);
+        roads[i] = RoadCursor();
+    }
+    if (inotifyFd >= 0) {
+        ::close(inotifyFd);
+        inotifyFd = -1;
+    }
+    opened = false;
+}
+
+bool LaneLogReader::openSegment(RoadCursor& road, char roadName,
+                                unsigned long long segment, long long offset) {
+    if (segment == 0) return false;
+
+    int fd = ::open(laneSegmentName(directory, roadName, segment).c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    VehicleFileHeader header;
+    if (pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))
+        || !header.isValid() || header.recordSize != sizeof(VehicleRecord)) {
+        std::cerr << "Error: lane " << roadName << " segment " << segment
+                  << " is not a supported log segment" << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    if (road.fd >= 0) ::close(road.fd);
+    road.fd = fd;
+    road.segment = segment;
+    road.offset = offset < HEADER_BYTES ? HEADER_BYTES : offset;
+    road.dirty = true;
+    return true;
+}
+
+void LaneLogReader::checkNotifications() {
+    if (inotifyFd < 0) {
+        for (int i = 0; i < 4; i++) roads[i].dirty = true;
+        return;
+    }
+
+#ifdef LANE_LOG_INOTIFY
+    alignas(struct inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) break;
+
+        for (char* p = buffer; p < buffer + length; ) {
+            struct inotify_event* event = reinterpret_cast<struct inotify_event*>(p);
+            if (event->mask & IN_Q_OVERFLOW) {
+                for (int i = 0; i < 4; i++) roads[i].dirty = true;
+            }
+            else if (event->len > 0 && isLogName(event->name)) {
+                roads[roadIndexOf(event->name[5])].dirty = true;
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+#endif
+}
+
+// Reads whatever whole records follow the road's offset in its segment
+int LaneLogReader::readAvailable(RoadCursor& road, std::vector<Vehicle>& out) {
+    int taken = 0;
+    size_t chunkBytes = chunk.size() * sizeof(VehicleRecord);
+
+    while (true) {
+        ssize_t length = pread(road.fd, chunk.data(), chunkBytes, road.offset);
+        if (length <= 0) break;
+
+        size_t count = length / sizeof(VehicleRecord);
+        for (size_t i = 0; i < count; i++) {
+            if (chunk[i].isValid()) {
+                out.push_back(chunk[i].toVehicle());
+                taken++;
+            }
+        }
+
+        // A half-written record stays for the next poll
+        road.offset += count * sizeof(VehicleRecord);
+        bytesRead += count * sizeof(VehicleRecord);
+        if (static_cast<size_t>(length) < chunkBytes) break;
+    }
+    return taken;
+}
+
+// Moves to the next segment once it exists. Nothing can be appended to the
+// current one after that, so it gets a last read and is deleted. Returns the
+// vehicles from that last read, or -1 if there is no next segment yet.
+int LaneLogReader::advanceSegment(RoadCursor& road, char roadName, std::vector<Vehicle>& out) {
+    RoadCursor next;
+    if (!openSegment(next, roadName, road.segment + 1, HEADER_BYTES)) {
+        return -1;
+    }
+
+    int taken = readAvailable(road, out);
+    std::string finished = laneSegmentName(directory, roadName, road.segment);
+
+    ::close(road.fd);
+    road.fd = next.fd;
+    road.segment = next.segment;
+    road.offset = next.offset;
+
+    // Record the move before deleting, so a crash in between cannot send a
+    // restarted reader back to the start of the old segment
+    saveCursor(road);
+    ::unlink(finished.c_str());
+    segmentsFinished++;
+    return taken;
+}
+
+void LaneLogReader::saveCursor(RoadCursor& road) {
+    if (road.cursorFd < 0) return;
+    uint64_t saved[2] = {road.segment, static_cast<uint64_t>(road.offset)};
+    if (pwrite(road.cursorFd, saved, sizeof(saved), 0) != static_cast<ssize_t>(sizeof(saved))) {
+        std::cerr << "Warning: could not save lane log cursor" << std::endl;
+    }
+}
+
+int LaneLogReader::poll(
+    std::vector<Vehicle>& lane_A,
+    std::vector<Vehicle>& lane_B,
+    std::vector<Vehicle>& lane_C,
+    std::vector<Vehicle>& lane_D
+) {
+    if (!opened) return 0;
+
+    pollCount++;
+    checkNotifications();
+
+    std::vector<Vehicle>* lanes[] = {&lane_A, &lane_B, &lane_C, &lane_D};
+    int taken = 0;
+    bool anyDirty = false;
+
+    for (int i = 0; i < 4; i++) {
+        RoadCursor& road = roads[i];
+        if (!road.dirty) continue;
+        road.dirty = false;
+        anyDirty = true;
+
+        // The writer may not have created this road's first segment yet
+        if (road.fd < 0) {
+            unsigned long long lowest, highest;
+            findSegments(directory, ROADS[i], lowest, highest);
+            if (!openSegment(road, ROADS[i], lowest, HEADER_BYTES)) continue;
+        }
+
+        int roadTaken = readAvailable(road, *lanes[i]);
+        int finalTaken;
+        while ((finalTaken = advanceSegment(road, ROADS[i], *lanes[i])) >= 0) {
+            roadTaken += finalTaken + readAvailable(road, *lanes[i]);
+        }
+        if (roadTaken > 0) {
+            saveCursor(road);
+        }
+        road.dirty = false;
+        taken += roadTaken;
+    }
+
+    if (!anyDirty) idlePolls++;
+    receivedCount += taken;
+    return taken;
+}
+
+#else
+
+LaneLogWriter::LaneLogWriter(long long maxSegmentBytes)
+    : maxSegmentBytes(maxSegmentBytes), rotations(0) {}
+LaneLogWriter::~LaneLogWriter() {}
+bool LaneLogWriter::open(const std::string& logDirectory) {
+    directory = logDirectory;
+    std::cerr << "Error: lane logs need a POSIX system" << std::endl;
+    return false;
+}
+void LaneLogWriter::close() {}
+bool LaneLogWriter::openSegment(int, unsigned long long, bool) { return false; }
+bool LaneLogWriter::flushRoad(int) { return false; }
+void LaneLogWriter::flush() {}
+bool LaneLogWriter::publish(const std::string&, char, int) { return false; }
+bool LaneLogWriter::publishRecord(const VehicleRecord&) { return false; }
+long long LaneLogWriter::getRotations() const { return rotations; }
+
+LaneLogReader::LaneLogReader()
+    : inotifyFd(-1), opened(false),
+      receivedCount(0), pollCount(0), idlePolls(0), segmentsFinished(0), bytesRead(0) {}
+LaneLogReader::~LaneLogReader() {}
+bool LaneLogReader::open(const std::string& logDirectory) {
+    directory = logDirectory;
+    std::cerr << "Error: lane logs need a POSIX system" << std::endl;
+    return false;
+}
+void LaneLogReader::close() {}
+int LaneLogReader::poll(std::vector<Vehicle>&, std::vector<Vehicle>&,
+                        std::vector<Vehicle>&, std::vector<Vehicle>&) { return 0; }
+
+#endif
+
+void LaneLogReader::printStats() const {
+    std::cout << "\n--- Lane Log " << directory << " ---" << std::endl;
+    std::cout << "Received:         " << receivedCount << " vehicles ("
+              << bytesRead << " bytes)" << std::endl;
+    std::cout << "Polls:            " << pollCount << " (" << idlePolls
+              << " idle, no files touched)" << std::endl;
+    std::cout << "Segments done:    " << segmentsFinished << std::endl;
+    std::cout << "Change watch:     " << (inotifyFd >= 0 ? "inotify" : "none (checks every poll)")
+              << std::endl;
+    for (int i = 0; i < 4; i++) {
+        std::cout << "  Road " << ROADS[i] << ": segment " << roads[i].segment
+                  << ", offset " << roads[i].offset << std::endl;
+    }
+}
@@ -0,0 +1,118 @@
+#ifndef LANELOG_H
+#define LANELOG_H
+
+#include <string>
+#include <vector>
+#include "VehicleFeed.h"
+#include "VehicleRecord.h"
+
+// Segmented, append-only lane logs: the lossless replacement for the
+// read-then-truncate lane files. Each road has numbered segment files
+//
+//     lane_A.000001.log  lane_A.000002.log  ...
+//
+// holding a VehicleFileHeader and then VehicleRecords. The writer only ever
+// appends to the newest segment. When that reaches the size limit it
+// prepares the next one under a temporary name and renames it into place,
+// so a segment is complete (sealed) as soon as its successor exists.
+//
+// The reader keeps a byte offset into its current segment and reads only
+// what was appended since the last poll. It saves (segment, offset) in
+// lane_X.cursor so a restarted simulator resumes where it stopped. Sealed
+// segments are deleted once read to the end. On Linux an inotify watch on
+// the directory tells it which roads changed, so an idle poll touches no
+// files at all.
+//
+// POSIX only; open() fails elsewhere.
+
+std::string laneSegmentName(const std::string& directory, char road, unsigned long long segment);
+
+class LaneLogWriter : public VehicleSink {
+private:
+    struct RoadLog {
+        int fd;
+        unsigned long long segment;
+        long long size;              // including what is still pending
+        std::vector<char> pending;   // records not yet written
+        RoadLog() : fd(-1), segment(0), size(0) {}
+    };
+
+    std::string directory;
+    long long maxSegmentBytes;
+    RoadLog roads[4];
+    long long rotations;
+
+    bool openSegment(int roadIndex, unsigned long long segment, bool create);
+    bool flushRoad(int roadIndex);
+
+    LaneLogWriter(const LaneLogWriter&);
+    LaneLogWriter& operator=(const LaneLogWriter&);
+
+public:
+    explicit LaneLogWriter(long long maxSegmentBytes = 4 * 1024 * 1024);
+    ~LaneLogWriter();
+
+    // Continues the newest segment of each road in the directory, or starts
+    // segment 1
+    bool open(const std::string& logDirectory);
+    void close();
+
+    bool publish(const std::string& plate, char road, int lane);
+    bool publishRecord(const VehicleRecord& record);
+    // Records are buffered per road and written in batches of up to 64 KiB;
+    // flush() writes whatever is pending
+    void flush();
+
+    long long getRotations() const;
+};
+
+class LaneLogReader : public VehicleSource {
+private:
+    struct RoadCursor {
+        int fd;                        // current segment, -1 until it exists
+        unsigned long long segment;
+        long long offset;              // bytes of the segment consumed so far
+        int cursorFd;
+        bool dirty;                    // may have new data
+        RoadCursor() : fd(-1), segment(0), offset(0), cursorFd(-1), dirty(true) {}
+    };
+
+    std::string directory;
+    RoadCursor roads[4];
+    int inotifyFd;
+    bool opened;
+    std::vector<VehicleRecord> chunk;
+
+    long long receivedCount;
+    long long pollCount;
+    long long idlePolls;
+    long long segmentsFinished;
+    long long bytesRead;
+
+    void checkNotifications();
+    bool openSegment(RoadCursor& road, char roadName, unsigned long long segment, long long offset);
+    int readAvailable(RoadCursor& road, std::vector<Vehicle>& out);
+    int advanceSegment(RoadCursor& road, char roadName, std::vector<Vehicle>& out);
+    void saveCursor(RoadCursor& road);
+
+    LaneLogReader(const LaneLogReader&);
+    LaneLogReader& operator=(const LaneLogReader&);
+
+public:
+    LaneLogReader();
+    ~LaneLogReader();
+
+    bool open(const std::string& logDirectory);
+    void close();
+
+    int poll(
+        std::vector<Vehicle>& lane_A,
+        std::vector<Vehicle>& lane_B,
+        std::vector<Vehicle>& lane_C,
+        std::vector<Vehicle>& lane_D
+    );
+
+    void printStats() const;
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "PlateRegistry.h"
+#include <unordered_map>
+#include <deque>
+#include <vector>
+#include <cstring>
+#include <mutex>
+
+namespace {
+
+// Looks plates up by their characters, so interning from a record's
+// buffer needs no std::string. Table keys point into PlateTable::plates.
+struct PlateKey {
+    const char* data;
+    size_t length;
+};
+
+struct PlateKeyHash {
+    size_t operator()(const PlateKey& key) const {
+        // FNV-1a
+        size_t hash = static_cast<size_t>(2166136261u);
+        for (size_t i = 0; i < key.length; i++) {
+            hash = (hash ^ static_cast<unsigned char>(key.data[i])) * 16777619u;
+        }
+        return hash;
+    }
+};
+
+struct PlateKeyEqual {
+    bool operator()(const PlateKey& a, const PlateKey& b) const {
+        return a.length == b.length && std::memcmp(a.data, b.data, a.length) == 0;
+    }
+};
+
+struct PlateTable {
+    std::mutex mutex;
+    std::unordered_map<PlateKey, uint32_t, PlateKeyHash, PlateKeyEqual> ids;
+    std::deque<std::string> plates;   // by ID; a deque never moves its elements
+    std::vector<uint32_t> freeIds;    // released, handed out again first
+
+    PlateTable() {
+        ids.reserve(4096);
+        plates.push_back(std::string());
+        PlateKey empty = {plates[0].data(), 0};
+        ids.insert(std::make_pair(empty, 0u));
+    }
+};
+
+// Constructed on first use so vehicles created during static
+// initialization still find it
+PlateTable& table() {
+    static PlateTable instance;
+    return instance;
+}
+
+}
+
+uint32_t PlateRegistry::intern(const std::string& plate) {
+    return intern(plate.data(), plate.size());
+}
+
+uint32_t PlateRegistry::intern(const char* plate, size_t length) {
+    PlateTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+
+    PlateKey key = {plate, length};
+    auto found = t.ids.find(key);
+    if (found != t.ids.end()) {
+        return found->second;
+    }
+
+    uint32_t id;
+    if (!t.freeIds.empty()) {
+        id = t.freeIds.back();
+        t.freeIds.pop_back();
+        t.plates[id].assign(plate, length);
+    } else {
+        id = static_cast<uint32_t>(t.plates.size());
+        t.plates.push_back(std::string(plate, length));
+    }
+    key.data = t.plates[id].data();
+    t.ids.insert(std::make_pair(key, id));
+    return id;
+}
+
+void PlateRegistry::release(uint32_t id) {
+    PlateTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+
+    // ID 0 and released IDs (empty text) stay as they are
+    if (id == 0 || id >= t.plates.size() || t.plates[id].empty()) {
+        return;
+    }
+    PlateKey key = {t.plates[id].data(), t.plates[id].size()};
+    t.ids.erase(key);
+    t.plates[id].clear();
+    t.freeIds.push_back(id);
+}
+
+std::string PlateRegistry::lookup(uint32_t id) {
+    PlateTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    return id < t.plates.size() ? t.plates[id] : std::string();
+}
+
+size_t PlateRegistry::size() {
+    PlateTable& t = table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    return t.plates.size() - t.freeIds.size();
+}
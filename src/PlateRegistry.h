@@ -0,0 +1,35 @@
+#ifndef PLATEREGISTRY_H
+#define PLATEREGISTRY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Process-wide intern table for license plates. Each distinct plate is
+// stored once and vehicles carry its 32-bit ID, so moving a Vehicle through
+// the readers, queues and active arrays never copies or allocates a string.
+// IDs are handed out in first-seen order and stay valid until released;
+// ID 0 is the empty plate.
+//
+// Safe to call from several threads. Producers on other threads hand over
+// raw VehicleRecords and leave the interning to the consumer, so the lock
+// stays off their hot paths.
+class PlateRegistry {
+public:
+    static uint32_t intern(const std::string& plate);
+    // Looks the characters up in place; only a plate seen for the first
+    // time is copied into the table
+    static uint32_t intern(const char* plate, size_t length);
+
+    // Forgets the plate so its ID can be handed out again. Only for plates
+    // no vehicle holds any more, e.g. synthetic ones whose vehicle left.
+    static void release(uint32_t id);
+
+    // Text of an interned plate, or "" for an unknown or released ID
+    static std::string lookup(uint32_t id);
+
+    // Plates currently interned
+    static size_t size();
+};
+
+#endif
@@ -3,48 +3,180 @@
 
 #include <stdexcept>
 #include <iostream>
+#include <new>
+#include <utility>
 
+// FIFO queue backed by a growable ring buffer. Elements live in one
+// contiguous block, so enqueue/dequeue do not touch the allocator except
+// when the buffer has to double. The capacity is always a power of two so
+// wrapping is a mask instead of a modulo.
 template <typename T>
 class Queue {
 private:
-     struct Node {
-          T data;
-          Node* next;
-          Node(T value ) : data(value), next(nullptr){}
-};
-     Node* frontptr;
-     Node* backptr;
+     T* buffer;
+     int capacity;
+     int head;
      int count;
+
+     enum { INITIAL_CAPACITY = 16 };
+
+     T* slot(int index) const { return buffer + ((head + index) & (capacity - 1)); }
+     void grow();
+     void copyFrom(const Queue& other);
+     void release();
 public:
      Queue();
+     Queue(const Queue& other);
+     Queue(Queue&& other);
+     Queue& operator=(const Queue& other);
+     Queue& operator=(Queue&& other);
      ~Queue();
-     void enqueue(T item);
+
+     void enqueue(const T& item);
+     void enqueue(T&& item);
+     template <typename... Args>
+     void emplace(Args&&... args);
      T dequeue();
-     T getFront() const;
+     const T& getFront() const;
+     T& getFront();
+     const T& at(int index) const;
      bool isEmpty() const;
      int getSize() const;
+     int getCapacity() const;
+     void clear();
+     void reserve(int minCapacity);
      void display() const;
 };
+
+template <typename T>
+Queue<T>::Queue() : buffer(nullptr), capacity(0), head(0), count(0) {}
+
+template <typename T>
+Queue<T>::Queue(const Queue& other) : buffer(nullptr), capacity(0), head(0), count(0) {
+     copyFrom(other);
+}
+
 template <typename T>
-Queue<T>::Queue() : frontptr(nullptr), backptr(nullptr), count(0) {}
+Queue<T>::Queue(Queue&& other)
+     : buffer(other.buffer), capacity(other.capacity), head(other.head), count(other.count) {
+     other.buffer = nullptr;
+     other.capacity = 0;
+     other.head = 0;
+     other.count = 0;
+}
+
+template <typename T>
+Queue<T>& Queue<T>::operator=(const Queue& other) {
+     if (this != &other) {
+          clear();
+          copyFrom(other);
+     }
+     return *this;
+}
+
+template <typename T>
+Queue<T>& Queue<T>::operator=(Queue&& other) {
+     if (this != &other) {
+          release();
+          buffer = other.buffer;
+          capacity = other.capacity;
+          head = other.head;
+          count = other.count;
+          other.buffer = nullptr;
+          other.capacity = 0;
+          other.head = 0;
+          other.count = 0;
+     }
+     return *this;
+}
 
 template <typename T>
 Queue<T>::~Queue() {
-     while (!isEmpty()) {
-          dequeue();
+     release();
+}
+
+template <typename T>
+void Queue<T>::copyFrom(const Queue& other) {
+     reserve(other.count);
+     for (int i = 0; i < other.count; i++) {
+          enqueue(*other.slot(i));
      }
 }
 
 template <typename T>
-void Queue<T>::enqueue(T item) {
-    Node* newNode = new Node(item);
-    
-    if (isEmpty()) {
-        frontptr = newNode;
-        backptr = newNode;
+void Queue<T>::release() {
+     clear();
+     ::operator delete(buffer);
+     buffer = nullptr;
+     capacity = 0;
+}
+
+template <typename T>
+void Queue<T>::reserve(int minCapacity) {
+     if (minCapacity <= capacity) {
+          return;
+     }
+
+     int newCapacity = (capacity == 0) ? INITIAL_CAPACITY : capacity;
+     while (newCapacity < minCapacity) {
+          newCapacity *= 2;
+     }
+
+     T* newBuffer = static_cast<T*>(::operator new(sizeof(T) * newCapacity));
+
+     // Unwrap into the new block so the front lands at index 0
+     for (int i = 0; i < count; i++) {
+          T* old = slot(i);
+          new (newBuffer + i) T(std::move(*old));
+          old->~T();
+     }
+
+     ::operator delete(buffer);
+     buffer = newBuffer;
+     capacity = newCapacity;
+     head = 0;
+}
+
+template <typename T>
+void Queue<T>::grow() {
+     reserve(capacity == 0 ? INITIAL_CAPACITY : capacity * 2);
+}
+
+template <typename T>
+void Queue<T>::enqueue(const T& item) {
+    if (count == capacity) {
+        // Copy first: item may refer to an element of this queue
+        T copy(item);
+        grow();
+        new (slot(count)) T(std::move(copy));
     } else {
-        backptr->next = newNode;
-        backptr = newNode;
+        new (slot(count)) T(item);
+    }
+    count++;
+}
+
+template <typename T>
+void Queue<T>::enqueue(T&& item) {
+    if (count == capacity) {
+        T moved(std::move(item));
+        grow();
+        new (slot(count)) T(std::move(moved));
+    } else {
+        new (slot(count)) T(std::move(item));
+    }
+    count++;
+}
+
+template <typename T>
+template <typename... Args>
+void Queue<T>::emplace(Args&&... args) {
+    if (count == capacity) {
+        // Build it first: an argument may refer to an element of this queue
+        T item(std::forward<Args>(args)...);
+        grow();
+        new (slot(count)) T(std::move(item));
+    } else {
+        new (slot(count)) T(std::forward<Args>(args)...);
     }
     count++;
 }
@@ -55,34 +187,47 @@ T Queue<T>::dequeue() {
     if (isEmpty()) {
         throw std::runtime_error("Queue is empty! Cannot dequeue.");
     }
-    
-    Node* temp = frontptr;
-    T data = temp->data;
 
-    frontptr = frontptr->next;
+    T* front = slot(0);
+    T data(std::move(*front));
+    front->~T();
 
-    if (frontptr == nullptr) {
-        backptr = nullptr;
-    }
-    
-    delete temp;
+    head = (head + 1) & (capacity - 1);
     count--;
     return data;
 }
 
 
 template <typename T>
-T Queue<T>::getFront() const {
+const T& Queue<T>::getFront() const {
+    if (isEmpty()) {
+        throw std::runtime_error("Queue is empty! Cannot get front.");
+    }
+    return *slot(0);
+}
+
+
+template <typename T>
+T& Queue<T>::getFront() {
     if (isEmpty()) {
         throw std::runtime_error("Queue is empty! Cannot get front.");
     }
-    return frontptr->data;
+    return *slot(0);
+}
+
+
+template <typename T>
+const T& Queue<T>::at(int index) const {
+    if (index < 0 || index >= count) {
+        throw std::out_of_range("Queue index out of range.");
+    }
+    return *slot(index);
 }
 
 
 template <typename T>
 bool Queue<T>::isEmpty() const {
-    return frontptr == nullptr;
+    return count == 0;
 }
 
 
@@ -92,6 +237,22 @@ int Queue<T>::getSize() const {
 }
 
 
+template <typename T>
+int Queue<T>::getCapacity() const {
+    return capacity;
+}
+
+
+template <typename T>
+void Queue<T>::clear() {
+    for (int i = 0; i < count; i++) {
+        slot(i)->~T();
+    }
+    head = 0;
+    count = 0;
+}
+
+
 template <typename T>
 void Queue<T>::display() const {
     if (isEmpty()) {
@@ -99,15 +260,10 @@ void Queue<T>::display() const {
         return;
     }
 
-    Node* current = frontptr;
     std::cout << "Queue contents (front to back):" << std::endl;
-    while (current != nullptr) {
-        current->data.display();
-        current = current->next;
+    for (int i = 0; i < count; i++) {
+        slot(i)->display();
     }
 }
 
 #endif
-
-
-
@@ -1,14 +1,27 @@
 #include "SDLRenderer.h"
+#include "FrameProfiler.h"
+#include "FrameCapture.h"
 #include <iostream>
 #include <cmath>
+#include <algorithm>
 #include <string>
 
 SDLRenderer::SDLRenderer(int width, int height) 
-    : window(nullptr), renderer(nullptr), 
-      windowWidth(width), windowHeight(height), isRunning(true) {}
+    : window(nullptr), renderer(nullptr), offscreenSurface(nullptr), roadLayer(nullptr), roadLayerFailed(false),
+      windowWidth(width), windowHeight(height),
+      worldWidth(width), worldHeight(height), cameraX(width * 0.5f), cameraY(height * 0.5f),
+      zoom(1.0f), queueBars(false), screenSpace(false), dragging(false), isRunning(true),
+      profiler(nullptr), overlayVisible(true), capture(nullptr), batchCount(0), groupByColor(false), groupCursor(0),
+      vehicleAtlas(nullptr), vehicleAtlasFailed(false) {
+    drawColor.r = drawColor.g = drawColor.b = 0;
+    drawColor.a = 255;
+}
 
 SDLRenderer::~SDLRenderer() {
+    releaseRoadLayer();
+    releaseVehicleAtlas();
     if (renderer) SDL_DestroyRenderer(renderer);
+    if (offscreenSurface) SDL_FreeSurface(offscreenSurface);
     if (window) SDL_DestroyWindow(window);
     SDL_Quit();
 }
@@ -41,21 +54,98 @@ bool SDLRenderer::init(const std::string& title) {
     return true;
 }
 
+bool SDLRenderer::initOffscreen() {
+    // The software renderer needs no video subsystem, so no display either
+    if (SDL_Init(0) < 0) {
+        std::cerr << "SDL Init Error: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    
+    offscreenSurface = SDL_CreateRGBSurfaceWithFormat(0, windowWidth, windowHeight, 32,
+                                                      SDL_PIXELFORMAT_ARGB8888);
+    if (!offscreenSurface) {
+        std::cerr << "Surface creation failed: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    
+    renderer = SDL_CreateSoftwareRenderer(offscreenSurface);
+    if (!renderer) {
+        std::cerr << "Renderer creation failed: " << SDL_GetError() << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
 void SDLRenderer::clear() {
+    batchCount = 0;   // anything queued would be cleared away anyway
+    spriteVertices.clear();
     setColor(128, 128, 128);  
+    applyColor();
     SDL_RenderClear(renderer);
 }
 
 void SDLRenderer::present() {
+    if (capture != nullptr) {
+        captureFrame();
+    }
+    if (profiler != nullptr && overlayVisible) {
+        drawProfilerOverlay();
+    }
+    flush();
     SDL_RenderPresent(renderer);
 }
 
 void SDLRenderer::handleEvents() {
+    if (offscreenSurface != nullptr) {
+        return;   // no window, no events
+    }
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
         if (event.type == SDL_QUIT) {
             isRunning = false;
         }
+        else if (event.type == SDL_KEYDOWN) {
+            // Pan a fixed distance on screen whatever the zoom
+            float step = 40.0f / zoom;
+            switch (event.key.keysym.sym) {
+                case SDLK_p: overlayVisible = !overlayVisible; break;
+                case SDLK_l: queueBars = !queueBars; break;
+                case SDLK_LEFT: moveCamera(-step, 0.0f, 1.0f); break;
+                case SDLK_RIGHT: moveCamera(step, 0.0f, 1.0f); break;
+                case SDLK_UP: moveCamera(0.0f, -step, 1.0f); break;
+                case SDLK_DOWN: moveCamera(0.0f, step, 1.0f); break;
+                case SDLK_EQUALS:
+                case SDLK_PLUS:
+                case SDLK_KP_PLUS: moveCamera(0.0f, 0.0f, 1.25f); break;
+                case SDLK_MINUS:
+                case SDLK_KP_MINUS: moveCamera(0.0f, 0.0f, 0.8f); break;
+                case SDLK_HOME:
+                case SDLK_0: resetCamera(); break;
+                default: break;
+            }
+        }
+        else if (event.type == SDL_MOUSEWHEEL && event.wheel.y != 0) {
+            moveCamera(0.0f, 0.0f, event.wheel.y > 0 ? 1.25f : 0.8f);
+        }
+        else if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT) {
+            dragging = true;
+        }
+        else if (event.type == SDL_MOUSEBUTTONUP && event.button.button == SDL_BUTTON_LEFT) {
+            dragging = false;
+        }
+        else if (event.type == SDL_MOUSEMOTION && dragging) {
+            moveCamera(-event.motion.xrel / zoom, -event.motion.yrel / zoom, 1.0f);
+        }
+        else if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+            // The road layer is in world pixels, so it stays as it is
+            SDL_GetRendererOutputSize(renderer, &windowWidth, &windowHeight);
+        }
+        else if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+            // Target texture contents are gone (e.g. Direct3D lost its device)
+            releaseRoadLayer();
+            releaseVehicleAtlas();
+        }
     }
 }
 
@@ -64,31 +154,221 @@ bool SDLRenderer::shouldClose() const {
 }
 
 void SDLRenderer::setColor(int r, int g, int b, int a) {
-    SDL_SetRenderDrawColor(renderer, r, g, b, a);
+    // Channels wrap like the Uint8 SDL_SetRenderDrawColor takes
+    drawColor.r = static_cast<Uint8>(r);
+    drawColor.g = static_cast<Uint8>(g);
+    drawColor.b = static_cast<Uint8>(b);
+    drawColor.a = static_cast<Uint8>(a);
+}
+
+void SDLRenderer::applyColor() {
+    SDL_SetRenderDrawColor(renderer, drawColor.r, drawColor.g, drawColor.b, drawColor.a);
+}
+
+static bool sameColor(const SDL_Color& a, const SDL_Color& b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+void SDLRenderer::setCamera(float centerX, float centerY, float zoomLevel) {
+    cameraX = centerX;
+    cameraY = centerY;
+    zoom = std::max(0.05f, std::min(zoomLevel, 8.0f));
+}
+
+void SDLRenderer::resetCamera() {
+    setCamera(worldWidth * 0.5f, worldHeight * 0.5f, 1.0f);
+}
+
+void SDLRenderer::moveCamera(float dx, float dy, float zoomFactor) {
+    setCamera(cameraX + dx, cameraY + dy, zoom * zoomFactor);
+}
+
+void SDLRenderer::setQueueBars(bool on) {
+    queueBars = on;
+}
+
+bool SDLRenderer::isZoomedOut() const {
+    return zoom < 0.35f;
+}
+
+int SDLRenderer::toScreenX(float x) const {
+    return static_cast<int>(std::floor((x - cameraX) * zoom + windowWidth * 0.5f + 0.5f));
+}
+
+int SDLRenderer::toScreenY(float y) const {
+    return static_cast<int>(std::floor((y - cameraY) * zoom + windowHeight * 0.5f + 0.5f));
+}
+
+bool SDLRenderer::toScreen(float x, float y, float w, float h, SDL_Rect& out) const {
+    // Both edges are rounded, so shapes that touch in the world still touch
+    out.x = toScreenX(x);
+    out.y = toScreenY(y);
+    out.w = toScreenX(x + w) - out.x;
+    out.h = toScreenY(y + h) - out.y;
+    return out.x < windowWidth && out.y < windowHeight && out.x + out.w > 0 && out.y + out.h > 0;
+}
+
+void SDLRenderer::viewBounds(int& left, int& top, int& right, int& bottom) const {
+    left = static_cast<int>(std::floor(cameraX - windowWidth * 0.5f / zoom));
+    top = static_cast<int>(std::floor(cameraY - windowHeight * 0.5f / zoom));
+    right = static_cast<int>(std::ceil(cameraX + windowWidth * 0.5f / zoom));
+    bottom = static_cast<int>(std::ceil(cameraY + windowHeight * 0.5f / zoom));
+}
+
+void SDLRenderer::addRect(const SDL_Rect& rect) {
+    if (screenSpace) {
+        queueRect(rect);
+        return;
+    }
+    SDL_Rect onScreen;
+    if (toScreen(rect.x, rect.y, rect.w, rect.h, onScreen) && onScreen.w > 0 && onScreen.h > 0) {
+        queueRect(onScreen);
+    }
+}
+
+void SDLRenderer::queueRect(const SDL_Rect& rect) {
+    flushSprites();   // sprites queued earlier lie underneath
+    
+    int index = -1;
+    if (groupByColor) {
+        // Only batches after the one this shape's object used last, so its
+        // parts still go out in the order they were drawn
+        for (int i = groupCursor; i < batchCount; i++) {
+            if (sameColor(batches[i].color, drawColor)) {
+                index = i;
+                break;
+            }
+        }
+    }
+    else if (batchCount > 0 && sameColor(batches[batchCount - 1].color, drawColor)) {
+        index = batchCount - 1;
+    }
+    
+    if (index < 0) {
+        if (batchCount == static_cast<int>(batches.size())) {
+            batches.push_back(RectBatch());
+        }
+        index = batchCount++;
+        batches[index].color = drawColor;
+        batches[index].rects.clear();
+    }
+    batches[index].rects.push_back(rect);
+    groupCursor = index;
+}
+
+void SDLRenderer::flushRects() {
+    for (int i = 0; i < batchCount; i++) {
+        const RectBatch& batch = batches[i];
+        SDL_SetRenderDrawColor(renderer, batch.color.r, batch.color.g, batch.color.b, batch.color.a);
+        SDL_RenderFillRects(renderer, batch.rects.data(), static_cast<int>(batch.rects.size()));
+    }
+    batchCount = 0;
+}
+
+void SDLRenderer::flushSprites() {
+    if (spriteVertices.empty()) {
+        return;
+    }
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    int quads = static_cast<int>(spriteVertices.size() / 4);
+    while (static_cast<int>(spriteIndices.size()) < quads * 6) {
+        int first = static_cast<int>(spriteIndices.size() / 6) * 4;
+        spriteIndices.push_back(first);
+        spriteIndices.push_back(first + 1);
+        spriteIndices.push_back(first + 2);
+        spriteIndices.push_back(first + 2);
+        spriteIndices.push_back(first + 3);
+        spriteIndices.push_back(first);
+    }
+    SDL_RenderGeometry(renderer, vehicleAtlas, spriteVertices.data(), quads * 4,
+                       spriteIndices.data(), quads * 6);
+#endif
+    spriteVertices.clear();
+}
+
+void SDLRenderer::flush() {
+    flushRects();
+    flushSprites();
+}
+
+void SDLRenderer::beginColorGroups() {
+    flush();
+    groupByColor = true;
+    groupCursor = 0;
+}
+
+void SDLRenderer::endColorGroups() {
+    flush();
+    groupByColor = false;
 }
 
 void SDLRenderer::drawRect(int x, int y, int w, int h, bool filled) {
     SDL_Rect rect = {x, y, w, h};
     if (filled) {
-        SDL_RenderFillRect(renderer, &rect);
-    } else {
-        SDL_RenderDrawRect(renderer, &rect);
+        addRect(rect);
+        return;
+    }
+    if (!screenSpace && !toScreen(x, y, w, h, rect)) {
+        return;
     }
+    flush();
+    applyColor();
+    SDL_RenderDrawRect(renderer, &rect);
 }
 
-void SDLRenderer::drawCircle(int centerX, int centerY, int radius) {
-    for (int w = 0; w < radius * 2; w++) {
+const std::vector<int>& SDLRenderer::spansFor(int radius) {
+    if (radius >= static_cast<int>(circleSpans.size())) {
+        circleSpans.resize(radius + 1);
+    }
+    std::vector<int>& spans = circleSpans[radius];
+    if (spans.empty()) {
+        // Row h is dy = radius - h; the row covers every dx in (-radius, radius]
+        // with dx*dx + dy*dy <= radius*radius, the pixels the point-by-point
+        // version used to plot
+        spans.resize(radius * 2);
         for (int h = 0; h < radius * 2; h++) {
-            int dx = radius - w;
             int dy = radius - h;
-            if ((dx*dx + dy*dy) <= (radius * radius)) {
-                SDL_RenderDrawPoint(renderer, centerX + dx, centerY + dy);
-            }
+            int half = static_cast<int>(std::sqrt(static_cast<double>(radius * radius - dy * dy)));
+            while (half * half > radius * radius - dy * dy) half--;
+            while ((half + 1) * (half + 1) <= radius * radius - dy * dy) half++;
+            spans[h] = half;
         }
     }
+    return spans;
+}
+
+void SDLRenderer::drawCircle(int centerX, int centerY, int radius) {
+    if (!screenSpace) {
+        // Scale the disc, not its rows, so it stays round when zoomed
+        SDL_Rect box;
+        if (!toScreen(centerX - radius, centerY - radius, radius * 2, radius * 2, box)) {
+            return;
+        }
+        centerX = toScreenX(centerX);
+        centerY = toScreenY(centerY);
+        radius = static_cast<int>(radius * zoom + 0.5f);
+    }
+    if (radius <= 0) {
+        return;
+    }
+    const std::vector<int>& spans = spansFor(radius);
+    for (int h = 0; h < radius * 2; h++) {
+        int half = spans[h];
+        int left = -std::min(half, radius - 1);
+        SDL_Rect row = {centerX + left, centerY + radius - h, half - left + 1, 1};
+        queueRect(row);
+    }
 }
 
 void SDLRenderer::drawLine(int x1, int y1, int x2, int y2) {
+    if (!screenSpace) {
+        x1 = toScreenX(x1);
+        y1 = toScreenY(y1);
+        x2 = toScreenX(x2);
+        y2 = toScreenY(y2);
+    }
+    flush();
+    applyColor();
     SDL_RenderDrawLine(renderer, x1, y1, x2, y2);
 }
 
@@ -127,34 +407,248 @@ void SDLRenderer::drawNumber(int number, int x, int y, int size) {
     }
 }
 
+// 3x5 glyphs, five rows of three pixels from the top, '#' = lit
+static const char* glyphRows(char c) {
+    switch (c) {
+        case '0': return "####.##.##.####";
+        case '1': return ".#.##..#..#.###";
+        case '2': return "###..#####..###";
+        case '3': return "###..####..####";
+        case '4': return "#.##.####..#..#";
+        case '5': return "####..###..####";
+        case '6': return "####..####.####";
+        case '7': return "###..#..#..#..#";
+        case '8': return "####.#####.####";
+        case '9': return "####.####..####";
+        case 'A': return ".#.#.#####.##.#";
+        case 'B': return "##.#.###.#.###.";
+        case 'C': return ".###..#..#...##";
+        case 'D': return "##.#.##.##.###.";
+        case 'E': return "####..##.#..###";
+        case 'F': return "####..##.#..#..";
+        case 'G': return ".###..#.##.#.##";
+        case 'H': return "#.##.#####.##.#";
+        case 'I': return "###.#..#..#.###";
+        case 'J': return "..#..#..##.#.#.";
+        case 'K': return "#.##.###.#.##.#";
+        case 'L': return "#..#..#..#..###";
+        case 'M': return "#.########.##.#";
+        case 'N': return "##.#.##.##.##.#";
+        case 'O': return ".#.#.##.##.#.#.";
+        case 'P': return "##.#.###.#..#..";
+        case 'Q': return ".#.#.##.###..##";
+        case 'R': return "##.#.###.#.##.#";
+        case 'S': return ".###...#...###.";
+        case 'T': return "###.#..#..#..#.";
+        case 'U': return "#.##.##.##.####";
+        case 'V': return "#.##.##.##.#.#.";
+        case 'W': return "#.##.########.#";
+        case 'X': return "#.##.#.#.#.##.#";
+        case 'Y': return "#.##.#.#..#..#.";
+        case 'Z': return "###..#.#.#..###";
+        case '.': return ".............#.";
+        case ':': return "....#.....#....";
+        case '-': return "......###......";
+        case '/': return "..#..#.#.#..#..";
+        case '%': return "#.#..#.#.#..#.#";
+        default: return nullptr;
+    }
+}
+
+void SDLRenderer::drawText(const std::string& text, int x, int y, int scale) {
+    for (size_t i = 0; i < text.size(); i++) {
+        char c = text[i];
+        if (c >= 'a' && c <= 'z') {
+            c = c - 'a' + 'A';
+        }
+        const char* rows = glyphRows(c);
+        if (rows == nullptr) {
+            continue;   // space or unsupported
+        }
+        
+        int glyphX = x + static_cast<int>(i) * 4 * scale;
+        for (int pixel = 0; pixel < 15; pixel++) {
+            if (rows[pixel] == '#') {
+                drawRect(glyphX + (pixel % 3) * scale, y + (pixel / 3) * scale, scale, scale);
+            }
+        }
+    }
+}
+
+void SDLRenderer::setFrameCapture(FrameCapture* frameCapture) {
+    capture = frameCapture;
+}
+
+void SDLRenderer::captureFrame() {
+    uint32_t* pixels = capture->beginFrame();
+    if (pixels == nullptr) {
+        return;
+    }
+    
+    flush();
+    if (windowWidth != capture->getWidth() || windowHeight != capture->getHeight()
+        || SDL_RenderReadPixels(renderer, nullptr, SDL_PIXELFORMAT_ARGB8888, pixels,
+                                windowWidth * 4) != 0) {
+        capture->abandonFrame();
+        return;
+    }
+    capture->commitFrame();
+}
+
+void SDLRenderer::setProfilerOverlay(const FrameProfiler* frameProfiler) {
+    profiler = frameProfiler;
+}
+
+// One row per phase: name, a bar of its average share of the frame budget
+// with a tick at its p99, then avg / p99 / max in microseconds. A phase whose
+// p99 alone would blow the budget turns red.
+void SDLRenderer::drawProfilerOverlay() {
+    const int left = 10;
+    const int top = 10;
+    const int rowHeight = 14;
+    const int barX = left + 70;
+    const int barWidth = 120;
+    const int textX = barX + barWidth + 10;
+    const float budget = profiler->getFrameBudget();
+    
+    flush();
+    screenSpace = true;
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    setColor(0, 0, 0, 170);
+    drawRect(left - 5, top - 5, 370, rowHeight * (PHASE_COUNT + 1) + 8);
+    flush();
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    
+    setColor(200, 200, 200);
+    drawText("PHASE", left, top);
+    drawText("US  AVG    P99    MAX", textX, top);
+    
+    for (int p = 0; p < PHASE_COUNT; p++) {
+        FramePhase phase = static_cast<FramePhase>(p);
+        PhaseSummary summary = profiler->summarize(phase);
+        int y = top + rowHeight * (p + 1);
+        
+        setColor(230, 230, 230);
+        drawText(FrameProfiler::phaseName(phase), left, y);
+        
+        int avgWidth = static_cast<int>(summary.avgMicros / budget * barWidth);
+        int p99Offset = static_cast<int>(summary.p99Micros / budget * barWidth);
+        setColor(60, 60, 60);
+        drawRect(barX, y, barWidth, 10);
+        if (summary.p99Micros > budget) {
+            setColor(220, 50, 50);
+        } else if (summary.p99Micros > budget / 2) {
+            setColor(230, 200, 40);
+        } else {
+            setColor(60, 200, 90);
+        }
+        drawRect(barX, y, std::min(avgWidth, barWidth), 10);
+        drawRect(barX + std::min(p99Offset, barWidth - 2), y - 1, 2, 12);
+        
+        setColor(230, 230, 230);
+        drawText(std::to_string(static_cast<int>(summary.avgMicros)), textX + 16 * 2, y);
+        drawText(std::to_string(static_cast<int>(summary.p99Micros)), textX + 16 * 2 + 56, y);
+        drawText(std::to_string(static_cast<int>(summary.maxMicros)), textX + 16 * 2 + 112, y);
+    }
+    screenSpace = false;
+}
+
 void SDLRenderer::drawRoad() {
-    int centerX = windowWidth / 2;
-    int centerY = windowHeight / 2;
+    if (roadLayer == nullptr && !roadLayerFailed && !renderRoadLayer()) {
+        roadLayerFailed = true;
+        std::cerr << "Road layer texture unavailable, drawing the road every frame: "
+                  << SDL_GetError() << std::endl;
+    }
+    
+    if (roadLayer != nullptr) {
+        flush();
+        SDL_Rect target;
+        if (toScreen(0.0f, 0.0f, worldWidth, worldHeight, target)) {
+            SDL_RenderCopy(renderer, roadLayer, nullptr, &target);
+        }
+        drawRoadExtensions();
+    } else {
+        int viewLeft, viewTop, viewRight, viewBottom;
+        viewBounds(viewLeft, viewTop, viewRight, viewBottom);
+        drawRoadScene(std::min(0, viewLeft), std::min(0, viewTop),
+                      std::max(worldWidth, viewRight), std::max(worldHeight, viewBottom));
+    }
+}
+
+bool SDLRenderer::renderRoadLayer() {
+    if (!SDL_RenderTargetSupported(renderer)) {
+        return false;
+    }
+    flush();   // queued shapes belong to the window, not the layer
+    
+    roadLayer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                  worldWidth, worldHeight);
+    if (roadLayer == nullptr) {
+        return false;
+    }
+    if (SDL_SetRenderTarget(renderer, roadLayer) != 0) {
+        releaseRoadLayer();
+        return false;
+    }
+    
+    // The layer is opaque and covers the whole scene, background included.
+    // World pixels map straight onto texels, whatever the camera does.
+    clear();
+    screenSpace = true;
+    drawRoadScene(0, 0, worldWidth, worldHeight);
+    flush();
+    screenSpace = false;
+    SDL_SetRenderTarget(renderer, nullptr);
+    return true;
+}
+
+void SDLRenderer::releaseRoadLayer() {
+    if (roadLayer != nullptr) {
+        SDL_DestroyTexture(roadLayer);
+        roadLayer = nullptr;
+    }
+}
+
+// Start of the dash on the 30 px pattern through origin that covers (or
+// last started before) position
+static int dashAt(int position, int origin) {
+    int offset = position - origin;
+    int steps = offset / 30 - (offset % 30 < 0 ? 1 : 0);
+    return origin + steps * 30;
+}
+
+void SDLRenderer::drawRoadScene(int viewLeft, int viewTop, int viewRight, int viewBottom) {
+    int centerX = worldWidth / 2;
+    int centerY = worldHeight / 2;
     int roadWidth = 180;
     int laneWidth = 60;
     
+    // First dash of each run still in view, on the scene's 30 px pattern
+    int firstX = dashAt(viewLeft, 10);
+    int firstY = dashAt(viewTop, 10);
+    
     setColor(50, 50, 50);
-    drawRect(0, centerY - roadWidth/2, windowWidth, roadWidth);
-    drawRect(centerX - roadWidth/2, 0, roadWidth, windowHeight);
+    drawRect(viewLeft, centerY - roadWidth/2, viewRight - viewLeft, roadWidth);
+    drawRect(centerX - roadWidth/2, viewTop, roadWidth, viewBottom - viewTop);
     
     setColor(255, 255, 255);
     
-    for (int x = 10; x < centerX - roadWidth/2 - 10; x += 30) {
+    for (int x = firstX; x < centerX - roadWidth/2 - 10; x += 30) {
         drawRect(x, centerY - roadWidth/2 + laneWidth - 2, 20, 4);
         drawRect(x, centerY - roadWidth/2 + 2*laneWidth - 2, 20, 4);
     }
     
-    for (int x = centerX + roadWidth/2 + 10; x < windowWidth - 10; x += 30) {
+    for (int x = centerX + roadWidth/2 + 10; x < viewRight - 10; x += 30) {
         drawRect(x, centerY - roadWidth/2 + laneWidth - 2, 20, 4);
         drawRect(x, centerY - roadWidth/2 + 2*laneWidth - 2, 20, 4);
     }
     
-    for (int y = 10; y < centerY - roadWidth/2 - 10; y += 30) {
+    for (int y = firstY; y < centerY - roadWidth/2 - 10; y += 30) {
         drawRect(centerX - roadWidth/2 + laneWidth - 2, y, 4, 20);
         drawRect(centerX - roadWidth/2 + 2*laneWidth - 2, y, 4, 20);
     }
     
-    for (int y = centerY + roadWidth/2 + 10; y < windowHeight - 10; y += 30) {
+    for (int y = centerY + roadWidth/2 + 10; y < viewBottom - 10; y += 30) {
         drawRect(centerX - roadWidth/2 + laneWidth - 2, y, 4, 20);
         drawRect(centerX - roadWidth/2 + 2*laneWidth - 2, y, 4, 20);
     }
@@ -175,17 +669,92 @@ void SDLRenderer::drawRoad() {
     }
     
     setColor(220, 180, 0);
-    drawRect(0, centerY - roadWidth/2 - 2, windowWidth, 2);
-    drawRect(0, centerY + roadWidth/2, windowWidth, 2);
-    drawRect(centerX - roadWidth/2 - 2, 0, 2, windowHeight);
-    drawRect(centerX + roadWidth/2, 0, 2, windowHeight);
+    drawRect(viewLeft, centerY - roadWidth/2 - 2, viewRight - viewLeft, 2);
+    drawRect(viewLeft, centerY + roadWidth/2, viewRight - viewLeft, 2);
+    drawRect(centerX - roadWidth/2 - 2, viewTop, 2, viewBottom - viewTop);
+    drawRect(centerX + roadWidth/2, viewTop, 2, viewBottom - viewTop);
     
     drawLaneLabels();
 }
 
+// The roads run on past the scene to wherever the window ends. The layer
+// holds only the scene, so the parts outside it are drawn here: per side
+// one strip of asphalt, its two edges and, while they are still a pixel
+// thick, the lane dashes on the same patterns as drawRoadScene.
+void SDLRenderer::drawRoadExtensions() {
+    int viewLeft, viewTop, viewRight, viewBottom;
+    viewBounds(viewLeft, viewTop, viewRight, viewBottom);
+    bool left = viewLeft < 0;
+    bool right = viewRight > worldWidth;
+    bool top = viewTop < 0;
+    bool bottom = viewBottom > worldHeight;
+    if (!left && !right && !top && !bottom) {
+        return;
+    }
+    
+    int centerX = worldWidth / 2;
+    int centerY = worldHeight / 2;
+    int roadWidth = 180;
+    int laneWidth = 60;
+    int roadTop = centerY - roadWidth/2;
+    int roadLeft = centerX - roadWidth/2;
+    
+    setColor(50, 50, 50);
+    if (left) drawRect(viewLeft, roadTop, -viewLeft, roadWidth);
+    if (right) drawRect(worldWidth, roadTop, viewRight - worldWidth, roadWidth);
+    if (top) drawRect(roadLeft, viewTop, roadWidth, -viewTop);
+    if (bottom) drawRect(roadLeft, worldHeight, roadWidth, viewBottom - worldHeight);
+    
+    if (zoom * 4.0f >= 1.0f) {
+        setColor(255, 255, 255);
+        if (left) {
+            for (int x = dashAt(viewLeft, 10); x < 0; x += 30) {
+                drawRect(x, roadTop + laneWidth - 2, 20, 4);
+                drawRect(x, roadTop + 2*laneWidth - 2, 20, 4);
+            }
+        }
+        if (right) {
+            for (int x = dashAt(worldWidth, centerX + roadWidth/2 + 10); x < viewRight - 10; x += 30) {
+                drawRect(x, roadTop + laneWidth - 2, 20, 4);
+                drawRect(x, roadTop + 2*laneWidth - 2, 20, 4);
+            }
+        }
+        if (top) {
+            for (int y = dashAt(viewTop, 10); y < 0; y += 30) {
+                drawRect(roadLeft + laneWidth - 2, y, 4, 20);
+                drawRect(roadLeft + 2*laneWidth - 2, y, 4, 20);
+            }
+        }
+        if (bottom) {
+            for (int y = dashAt(worldHeight, centerY + roadWidth/2 + 10); y < viewBottom - 10; y += 30) {
+                drawRect(roadLeft + laneWidth - 2, y, 4, 20);
+                drawRect(roadLeft + 2*laneWidth - 2, y, 4, 20);
+            }
+        }
+    }
+    
+    setColor(220, 180, 0);
+    if (left) {
+        drawRect(viewLeft, roadTop - 2, -viewLeft, 2);
+        drawRect(viewLeft, centerY + roadWidth/2, -viewLeft, 2);
+    }
+    if (right) {
+        drawRect(worldWidth, roadTop - 2, viewRight - worldWidth, 2);
+        drawRect(worldWidth, centerY + roadWidth/2, viewRight - worldWidth, 2);
+    }
+    if (top) {
+        drawRect(roadLeft - 2, viewTop, 2, -viewTop);
+        drawRect(centerX + roadWidth/2, viewTop, 2, -viewTop);
+    }
+    if (bottom) {
+        drawRect(roadLeft - 2, worldHeight, 2, viewBottom - worldHeight);
+        drawRect(centerX + roadWidth/2, worldHeight, 2, viewBottom - worldHeight);
+    }
+}
+
 void SDLRenderer::drawLaneLabels() {
-    int centerX = windowWidth / 2;
-    int centerY = windowHeight / 2;
+    int centerX = worldWidth / 2;
+    int centerY = worldHeight / 2;
     int roadWidth = 180;
     int laneWidth = 60;
     
@@ -201,20 +770,20 @@ void SDLRenderer::drawLaneLabels() {
     drawNumber(2, centerX - roadWidth/2 + laneWidth + 20, labelY, 10);
     drawNumber(3, centerX - roadWidth/2 + 2*laneWidth + 20, labelY, 10);
     
-    labelX = windowWidth - 40;
+    labelX = worldWidth - 40;
     drawNumber(1, labelX, centerY - roadWidth/2 + 20, 10);
     drawNumber(2, labelX, centerY - roadWidth/2 + laneWidth + 20, 10);
     drawNumber(3, labelX, centerY - roadWidth/2 + 2*laneWidth + 20, 10);
     
-    labelY = windowHeight - 40;
+    labelY = worldHeight - 40;
     drawNumber(1, centerX - roadWidth/2 + 20, labelY, 10);
     drawNumber(2, centerX - roadWidth/2 + laneWidth + 20, labelY, 10);
     drawNumber(3, centerX - roadWidth/2 + 2*laneWidth + 20, labelY, 10);
 }
 
 void SDLRenderer::drawTrafficLight(char currentLane, bool isPriority) {
-    int centerX = windowWidth / 2;
-    int centerY = windowHeight / 2;
+    int centerX = worldWidth / 2;
+    int centerY = worldHeight / 2;
     int offset = 120;
     
     drawTrafficLightBox(centerX - offset, centerY, currentLane == 'A');
@@ -256,60 +825,225 @@ void SDLRenderer::drawTrafficLightBox(int x, int y, bool isGreen) {
     }
 }
 
-void SDLRenderer::drawAnimatedVehicle(float x, float y, char road, int lane) {
-    int carWidth = 20;
-    int carHeight = 35;
-    
-    // Determine car color based on road
-    int bodyR, bodyG, bodyB;
+// Atlas cells leave a transparent pixel around the 20x35 car, whose wheels
+// reach one row below it
+static const int SPRITE_PAD = 1;
+static const int SPRITE_WIDTH = 20 + 2 * SPRITE_PAD;
+static const int SPRITE_HEIGHT = 36 + 2 * SPRITE_PAD;
+static const char SPRITE_ROADS[] = {'A', 'B', 'C', 'D'};
+static const int SPRITE_COUNT = 4;
+
+// drawVehicleShapes treats any road other than A, B and C like D
+static int spriteIndex(char road) {
+    return road == 'A' ? 0 : road == 'B' ? 1 : road == 'C' ? 2 : 3;
+}
+
+// Determine car color based on road
+static void roadColor(char road, int& r, int& g, int& b) {
     if (road == 'A') {
-        bodyR = 0; bodyG = 120; bodyB = 255;  // Blue
+        r = 0; g = 120; b = 255;  // Blue
     } else if (road == 'B') {
-        bodyR = 0; bodyG = 200; bodyB = 50;   // Green
+        r = 0; g = 200; b = 50;   // Green
     } else if (road == 'C') {
-        bodyR = 255; bodyG = 140; bodyB = 0;  // Orange
+        r = 255; g = 140; b = 0;  // Orange
     } else {
-        bodyR = 220; bodyG = 20; bodyB = 220; // Purple
+        r = 220; g = 20; b = 220; // Purple
+    }
+}
+
+bool SDLRenderer::renderVehicleAtlas() {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (!SDL_RenderTargetSupported(renderer)) {
+        return false;
+    }
+    flush();   // queued shapes belong to the window, not the atlas
+    
+    vehicleAtlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET,
+                                     SPRITE_WIDTH * SPRITE_COUNT, SPRITE_HEIGHT);
+    if (vehicleAtlas == nullptr) {
+        return false;
+    }
+    if (SDL_SetRenderTarget(renderer, vehicleAtlas) != 0) {
+        releaseVehicleAtlas();
+        return false;
+    }
+    SDL_SetTextureBlendMode(vehicleAtlas, SDL_BLENDMODE_BLEND);
+    
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+    screenSpace = true;   // atlas cells, not the world
+    for (int i = 0; i < SPRITE_COUNT; i++) {
+        drawVehicleShapes(i * SPRITE_WIDTH + SPRITE_PAD, SPRITE_PAD, SPRITE_ROADS[i]);
+    }
+    screenSpace = false;
+    flushRects();
+    SDL_SetRenderTarget(renderer, nullptr);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SDLRenderer::releaseVehicleAtlas() {
+    if (vehicleAtlas != nullptr) {
+        SDL_DestroyTexture(vehicleAtlas);
+        vehicleAtlas = nullptr;
+    }
+}
+
+bool SDLRenderer::drawAnimatedVehicle(float x, float y, char road, int lane) {
+    // Same whole-pixel placement as the shapes
+    SDL_Rect box;
+    if (!toScreen((int)x - SPRITE_PAD, (int)y - SPRITE_PAD, SPRITE_WIDTH, SPRITE_HEIGHT, box)) {
+        return false;
     }
     
+    if (vehicleAtlas == nullptr && !vehicleAtlasFailed && !renderVehicleAtlas()) {
+        vehicleAtlasFailed = true;
+        std::cerr << "Vehicle sprites unavailable, drawing vehicles from shapes: "
+                  << SDL_GetError() << std::endl;
+    }
+    
+    if (vehicleAtlas == nullptr) {
+        drawVehicleShapes((int)x, (int)y, road);
+        return true;
+    }
+    
+    flushRects();   // shapes queued earlier lie underneath
+    
+    float atlasWidth = static_cast<float>(SPRITE_WIDTH * SPRITE_COUNT);
+    float u0 = static_cast<float>(spriteIndex(road) * SPRITE_WIDTH) / atlasWidth;
+    float u1 = u0 + SPRITE_WIDTH / atlasWidth;
+    float left = static_cast<float>(box.x);
+    float top = static_cast<float>(box.y);
+    float right = static_cast<float>(box.x + box.w);
+    float bottom = static_cast<float>(box.y + box.h);
+    
+    SDL_Vertex corner;
+    corner.color.r = corner.color.g = corner.color.b = corner.color.a = 255;
+    corner.position.x = left;  corner.position.y = top;    corner.tex_coord.x = u0; corner.tex_coord.y = 0.0f;
+    spriteVertices.push_back(corner);
+    corner.position.x = right; corner.position.y = top;    corner.tex_coord.x = u1; corner.tex_coord.y = 0.0f;
+    spriteVertices.push_back(corner);
+    corner.position.x = right; corner.position.y = bottom; corner.tex_coord.x = u1; corner.tex_coord.y = 1.0f;
+    spriteVertices.push_back(corner);
+    corner.position.x = left;  corner.position.y = bottom; corner.tex_coord.x = u0; corner.tex_coord.y = 1.0f;
+    spriteVertices.push_back(corner);
+    return true;
+}
+
+void SDLRenderer::drawVehicleShapes(int x, int y, char road) {
+    groupCursor = 0;   // a new object for beginColorGroups
+    int carWidth = 20;
+    int carHeight = 35;
+    
+    int bodyR, bodyG, bodyB;
+    roadColor(road, bodyR, bodyG, bodyB);
+    
     // Draw car body (rounded rectangle approximation)
     setColor(bodyR, bodyG, bodyB);
-    drawRect((int)x + 2, (int)y, carWidth - 4, carHeight);  // Main body
+    drawRect(x + 2, y, carWidth - 4, carHeight);  // Main body
     
     // Draw car roof/windows
     setColor(bodyR + 50, bodyG + 50, bodyB + 50);  // Lighter shade
-    drawRect((int)x + 4, (int)y + 3, carWidth - 8, 12);  // Roof
+    drawRect(x + 4, y + 3, carWidth - 8, 12);  // Roof
     
     // Draw windows
     setColor(200, 220, 255);  // Light blue for windows
-    drawRect((int)x + 5, (int)y + 4, carWidth - 10, 4);  // Front window
-    drawRect((int)x + 5, (int)y + 10, carWidth - 10, 4); // Rear window
+    drawRect(x + 5, y + 4, carWidth - 10, 4);  // Front window
+    drawRect(x + 5, y + 10, carWidth - 10, 4); // Rear window
     
     // Draw wheels
     setColor(30, 30, 30);  // Dark gray for tires
-    drawCircle((int)x + 5, (int)y + carHeight - 3, 3);   // Front wheel
-    drawCircle((int)x + carWidth - 5, (int)y + carHeight - 3, 3); // Rear wheel
+    drawCircle(x + 5, y + carHeight - 3, 3);   // Front wheel
+    drawCircle(x + carWidth - 5, y + carHeight - 3, 3); // Rear wheel
     
     // Draw wheel rims
     setColor(150, 150, 150);  // Light gray for rims
-    drawCircle((int)x + 5, (int)y + carHeight - 3, 1);   // Front rim
-    drawCircle((int)x + carWidth - 5, (int)y + carHeight - 3, 1); // Rear rim
+    drawCircle(x + 5, y + carHeight - 3, 1);   // Front rim
+    drawCircle(x + carWidth - 5, y + carHeight - 3, 1); // Rear rim
     
     // Draw headlights/taillights
     if (road == 'A' || road == 'C') {  // Horizontal roads
         setColor(255, 255, 200);  // Yellow for headlights
-        drawRect((int)x + carWidth - 2, (int)y + 5, 2, 3);  // Front light
+        drawRect(x + carWidth - 2, y + 5, 2, 3);  // Front light
         setColor(255, 0, 0);  // Red for taillights
-        drawRect((int)x, (int)y + 5, 2, 3);  // Rear light
+        drawRect(x, y + 5, 2, 3);  // Rear light
     } else {  // Vertical roads
         setColor(255, 255, 200);  // Yellow for headlights
-        drawRect((int)x + 5, (int)y, 3, 2);  // Front light
+        drawRect(x + 5, y, 3, 2);  // Front light
         setColor(255, 0, 0);  // Red for taillights
-        drawRect((int)x + 5, (int)y + carHeight - 2, 3, 2);  // Rear light
+        drawRect(x + 5, y + carHeight - 2, 3, 2);  // Rear light
     }
 }
 
-void SDLRenderer::drawQueue(char lane, int queueSize) {
+void SDLRenderer::drawQueue(char road, int lane, int queueSize) {
+    if (queueSize <= 0 || lane < 1 || lane > 3) {
+        return;
+    }
+    
+    // The layout TrafficManager::waitingTarget queues cars in
+    const int roadWidth = 180;
+    const int laneWidth = 60;
+    const int carLength = 35;
+    const int stopDistance = roadWidth/2 + 20;
+    const int thickness = 12;
+    int centerX = worldWidth / 2;
+    int centerY = worldHeight / 2;
+    int laneCenter = -roadWidth/2 + (lane - 1) * laneWidth + laneWidth/2;
+    int length = queueSize * carLength;
+    bool horizontal = (road == 'A' || road == 'C');
+    
+    float x, y, w, h;
+    if (horizontal) {
+        x = (road == 'A') ? centerX - stopDistance - length : centerX + stopDistance;
+        y = centerY + laneCenter - thickness / 2;
+        w = length;
+        h = thickness;
+    } else {
+        x = centerX + laneCenter - thickness / 2;
+        y = (road == 'B') ? centerY - stopDistance - length : centerY + stopDistance;
+        w = thickness;
+        h = length;
+    }
+    
+    // Clip to the window; a bar wholly past one edge is pinned to it
+    const int pinned = 6;
+    SDL_Rect bar;
+    toScreen(x, y, w, h, bar);
+    int left = std::max(bar.x, 0);
+    int right = std::min(bar.x + bar.w, windowWidth);
+    int top = std::max(bar.y, 0);
+    int bottom = std::min(bar.y + bar.h, windowHeight);
+    if (horizontal) {
+        if (top >= bottom) return;   // the lane itself is out of view
+        if (left >= right) {
+            left = (bar.x + bar.w <= 0) ? 0 : windowWidth - pinned;
+            right = left + pinned;
+        }
+    } else {
+        if (left >= right) return;
+        if (top >= bottom) {
+            top = (bar.y + bar.h <= 0) ? 0 : windowHeight - pinned;
+            bottom = top + pinned;
+        }
+    }
+    
+    int barR, barG, barB;
+    roadColor(road, barR, barG, barB);
+    SDL_Rect clipped = {left, top, right - left, bottom - top};
+    setColor(barR, barG, barB);
+    queueRect(clipped);
+    
+    // The count next to the bar, kept inside the window
+    std::string count = std::to_string(queueSize);
+    int textWidth = static_cast<int>(count.size()) * 8;
+    int textX = std::max(2, std::min(left + 2, windowWidth - textWidth - 2));
+    int textY = std::max(2, std::min(top - 12, windowHeight - 12));
+    screenSpace = true;
+    setColor(255, 255, 255);
+    drawText(count, textX, textY);
+    screenSpace = false;
 }
 
 void SDLRenderer::drawStats(int cycle, int totalProcessed, int priorityCount) {
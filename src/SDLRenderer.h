@@ -3,39 +3,153 @@
 
 #include <SDL2/SDL.h>
 #include <string>
+#include <vector>
+
+class FrameProfiler;
+class FrameCapture;
 
 class SDLRenderer {
 private:
+    // Filled rectangles of one colour waiting for SDL_RenderFillRects
+    struct RectBatch {
+        SDL_Color color;
+        std::vector<SDL_Rect> rects;
+    };
+    
     SDL_Window* window;
     SDL_Renderer* renderer;
+    SDL_Surface* offscreenSurface;   // set when drawing without a window
+    SDL_Texture* roadLayer;   // the static scene, one texel per world pixel
+    bool roadLayerFailed;     // no render targets: draw the road every frame
     int windowWidth;
     int windowHeight;
+    // The scene the simulation lays out (its intersection sits at the
+    // centre); the window shows it through the camera
+    int worldWidth;
+    int worldHeight;
+    float cameraX;        // world point at the centre of the window
+    float cameraY;
+    float zoom;           // window pixels per world pixel
+    bool queueBars;       // LOD: vehicles not drawn are summed up per lane
+    bool screenSpace;     // drawing skips the camera (overlay, atlas, labels)
+    bool dragging;
     bool isRunning;
+    const FrameProfiler* profiler;
+    bool overlayVisible;
+    FrameCapture* capture;
+    
+    SDL_Color drawColor;
+    std::vector<RectBatch> batches;   // reused; only the first batchCount are live
+    int batchCount;
+    bool groupByColor;
+    int groupCursor;
+    // Per radius, the rightmost dx of each of the 2r rows of a disc
+    std::vector<std::vector<int> > circleSpans;
     
+    // One picture per vehicle look, side by side; every vehicle on screen
+    // is a textured quad of it, all sent in one SDL_RenderGeometry call
+    SDL_Texture* vehicleAtlas;
+    bool vehicleAtlasFailed;
+    std::vector<SDL_Vertex> spriteVertices;
+    std::vector<int> spriteIndices;
+    
+    void addRect(const SDL_Rect& rect);
+    void queueRect(const SDL_Rect& rect);
+    int toScreenX(float x) const;
+    int toScreenY(float y) const;
+    // World box to window pixels; false when it is entirely outside
+    bool toScreen(float x, float y, float w, float h, SDL_Rect& out) const;
+    // World box the window shows, rounded outward
+    void viewBounds(int& left, int& top, int& right, int& bottom) const;
+    void moveCamera(float dx, float dy, float zoomFactor);
+    void flushRects();
+    void flushSprites();
+    void flush();
+    void applyColor();
+    const std::vector<int>& spansFor(int radius);
     void drawDigit(int digit, int x, int y, int size);
     void drawNumber(int number, int x, int y, int size);
     void drawLaneLabels();
+    // The road scene, with the roads running on to the given world box
+    void drawRoadScene(int viewLeft, int viewTop, int viewRight, int viewBottom);
+    void drawRoadExtensions();
+    bool renderRoadLayer();
+    void releaseRoadLayer();
+    bool renderVehicleAtlas();
+    void releaseVehicleAtlas();
+    void drawVehicleShapes(int x, int y, char road);
     void drawTrafficLightBox(int x, int y, bool isGreen);
+    void drawProfilerOverlay();
+    void captureFrame();
     
 public:
     SDLRenderer(int width, int height);
     ~SDLRenderer();
     
     bool init(const std::string& title);
+    // No window and no GPU: a software renderer drawing into a memory
+    // surface, for headless servers. shouldClose() never turns true.
+    bool initOffscreen();
+    bool isOffscreen() const { return offscreenSurface != nullptr; }
+    int getWidth() const { return windowWidth; }
+    int getHeight() const { return windowHeight; }
     void clear();
     void present();
     void handleEvents();
     bool shouldClose() const;
     
+    // Filled rectangles and circles are queued and sent with one
+    // SDL_RenderFillRects per run of the same colour. Outlines, lines and
+    // texture copies flush the queue first, so the drawing order is kept.
     void setColor(int r, int g, int b, int a = 255);
     void drawRect(int x, int y, int w, int h, bool filled = true);
+    // Filled disc, one rectangle per pixel row
     void drawCircle(int centerX, int centerY, int radius);
     void drawLine(int x1, int y1, int x2, int y2);
+    // Upper-case 3x5 pixel font (letters, digits, . : - / %), each pixel
+    // drawn scale x scale
+    void drawText(const std::string& text, int x, int y, int scale = 2);
+    
+    // Frame phase timings drawn over the scene by present() (not owned,
+    // nullptr for none); P toggles it
+    void setProfilerOverlay(const FrameProfiler* frameProfiler);
+    // Every presented frame, without the overlay, is offered to it (not
+    // owned, nullptr for none). Frames of another size are dropped.
+    void setFrameCapture(FrameCapture* frameCapture);
+    
+    // Everything but the overlay is drawn through a pan/zoom camera, and
+    // shapes outside the window are skipped before they reach SDL. Arrow
+    // keys or dragging pan, the wheel or +/- zoom, Home or 0 goes back to
+    // the whole scene, L toggles the queue bars.
+    void setCamera(float centerX, float centerY, float zoomLevel);
+    void resetCamera();
+    float getZoom() const { return zoom; }
+    void setQueueBars(bool on);
+    bool showsQueueBars() const { return queueBars; }
+    // Zoomed out so far that single cars are a few pixels: with queue bars
+    // on, lanes are drawn as bars only
+    bool isZoomedOut() const;
     
+    // Asphalt, lane markings, stop lines, edges and lane numbers. They never
+    // change, so they are drawn into a world-sized texture once (again after
+    // a lost device) and each frame copies it through the camera. Only the
+    // roads beyond the scene's edges are drawn per frame.
     void drawRoad();
+    // Between these, filled shapes are grouped by colour rather than by run,
+    // so n vehicles cost one call per colour instead of a dozen each. Each
+    // vehicle's own parts keep their order, but a vehicle may end up over
+    // or under another, so only use it for things that do not overlap.
+    void beginColorGroups();
+    void endColorGroups();
     void drawTrafficLight(char currentLane, bool isPriority);
-    void drawAnimatedVehicle(float x, float y, char road, int lane);
-    void drawQueue(char lane, int queueSize);
+    // Queued as a sprite when the atlas is available, otherwise drawn
+    // from rectangles and circles. False (and nothing drawn) when the
+    // vehicle is outside the window.
+    bool drawAnimatedVehicle(float x, float y, char road, int lane);
+    // LOD bar for queueSize vehicles of one lane that were not drawn: as
+    // long as that many cars queued back from the stop line, kept on screen
+    // at the window edge, with the count beside it
+    void drawQueue(char road, int lane, int queueSize);
     void drawStats(int cycle, int totalProcessed, int priorityCount);
     void drawVehicle(int x, int y, char lane);
     void drawSingleLight(int x, int y, bool isGreen, int radius = 12, int glowRadius = 15);
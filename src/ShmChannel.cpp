@@ -0,0 +1,294 @@
+#include "ShmChannel.h"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SHM_CHANNEL_SUPPORTED 1
+#endif
+
+ShmChannel::ShmChannel()
+    : header(nullptr), records(nullptr), mappedBytes(0), mask(0),
+      nextWriteSequence(0), cachedReadSequence(0), publishedCount(0), fullWaits(0), stopWaitingRequested(false),
+      resumedFrom(0), receivedCount(0), maxBacklog(0), latencySumNs(0), maxLatencyNs(0)
+{
+}
+
+ShmChannel::~ShmChannel() {
+    close();
+}
+
+static std::string shmPath(const std::string& channelName) {
+    return channelName.empty() || channelName[0] != '/' ? "/" + channelName : channelName;
+}
+
+#ifdef SHM_CHANNEL_SUPPORTED
+
+// The counters are shared between processes, which only works when they are
+// plain lock-free memory operations
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared counters must be lock-free");
+
+bool ShmChannel::open(const std::string& channelName, size_t capacity) {
+    close();
+    name = shmPath(channelName);
+
+    uint64_t roundedCapacity = 1;
+    while (roundedCapacity < capacity) {
+        roundedCapacity <<= 1;
+    }
+
+    // Whoever manages to create the object initializes it; everyone else
+    // waits until the header is published
+    bool created = true;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = shm_open(name.c_str(), O_RDWR, 0600);
+    }
+    if (fd < 0) {
+        std::cerr << "Error: shm_open(" << name << "): " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    size_t size = 0;
+    if (created) {
+        size = sizeof(Header) + roundedCapacity * sizeof(VehicleRecord);
+        if (ftruncate(fd, size) != 0) {
+            std::cerr << "Error: ftruncate(" << name << "): " << std::strerror(errno) << std::endl;
+            ::close(fd);
+            shm_unlink(name.c_str());
+            return false;
+        }
+    }
+    else {
+        struct stat info;
+        for (int attempt = 0; attempt < 2000; attempt++) {
+            if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(Header)) {
+                size = info.st_size;
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (size == 0) {
+            std::cerr << "Error: shared memory channel " << name << " was never initialized" << std::endl;
+            ::close(fd);
+            return false;
+        }
+    }
+
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        std::cerr << "Error: mmap(" << name << "): " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    mappedBytes = size;
+
+    if (created) {
+        header = new (memory) Header();
+        header->version = VERSION;
+        header->recordSize = sizeof(VehicleRecord);
+        header->capacity = roundedCapacity;
+        header->writeSequence.store(0);
+        header->readSequence.store(0);
+        header->magic.store(MAGIC, std::memory_order_release);
+    }
+    else {
+        header = static_cast<Header*>(memory);
+        for (int attempt = 0; attempt < 2000; attempt++) {
+            if (header->magic.load(std::memory_order_acquire) == MAGIC) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if (header->magic.load(std::memory_order_acquire) != MAGIC
+            || header->version != VERSION
+            || header->recordSize != sizeof(VehicleRecord)
+            || sizeof(Header) + header->capacity * sizeof(VehicleRecord) > size) {
+            std::cerr << "Error: " << name << " is not a compatible vehicle channel" << std::endl;
+            close();
+            return false;
+        }
+    }
+
+    records = reinterpret_cast<VehicleRecord*>(static_cast<char*>(memory) + sizeof(Header));
+    mask = header->capacity - 1;
+
+    nextWriteSequence = header->writeSequence.load(std::memory_order_acquire);
+    cachedReadSequence = header->readSequence.load(std::memory_order_acquire);
+    resumedFrom = cachedReadSequence;
+    return true;
+}
+
+void ShmChannel::close() {
+    if (header != nullptr) {
+        flush();
+        munmap(header, mappedBytes);
+    }
+    header = nullptr;
+    records = nullptr;
+    mappedBytes = 0;
+}
+
+bool ShmChannel::remove(const std::string& channelName) {
+    return shm_unlink(shmPath(channelName).c_str()) == 0;
+}
+
+#else
+
+bool ShmChannel::open(const std::string& channelName, size_t) {
+    name = shmPath(channelName);
+    std::cerr << "Error: shared memory channels need a POSIX system" << std::endl;
+    return false;
+}
+
+void ShmChannel::close() {
+    header = nullptr;
+    records = nullptr;
+}
+
+bool ShmChannel::remove(const std::string&) {
+    return false;
+}
+
+#endif
+
+bool ShmChannel::isOpen() const {
+    return header != nullptr;
+}
+
+bool ShmChannel::publish(const std::string& plate, char road, int lane) {
+    return publishRecord(VehicleRecord::make(plate, road, lane, epochNanoseconds()));
+}
+
+bool ShmChannel::publishRecord(const VehicleRecord& record) {
+    if (header == nullptr) {
+        return false;
+    }
+
+    uint64_t sequence = nextWriteSequence;
+    if (sequence - cachedReadSequence > mask) {
+        // The consumer can only free slots it can see
+        flush();
+        fullWaits++;
+        int spins = 0;
+        while (true) {
+            cachedReadSequence = header->readSequence.load(std::memory_order_acquire);
+            if (sequence - cachedReadSequence <= mask) break;
+            if (stopWaitingRequested.load(std::memory_order_relaxed)) return false;
+
+            // The simulator drains once per tick; nap instead of burning a
+            // core when it is not keeping up (or not running)
+            if (++spins < 64) {
+                std::this_thread::yield();
+            } else {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+    }
+
+    records[sequence & mask] = record;
+    nextWriteSequence = sequence + 1;
+    publishedCount++;
+
+    // One shared store per batch instead of per record keeps the counter's
+    // cache line from bouncing between the processes
+    if (nextWriteSequence - header->writeSequence.load(std::memory_order_relaxed) >= 256) {
+        flush();
+    }
+    return true;
+}
+
+void ShmChannel::flush() {
+    // publishedCount keeps a consumer from ever storing its stale copy
+    if (header != nullptr && publishedCount > 0
+        && nextWriteSequence != header->writeSequence.load(std::memory_order_relaxed)) {
+        header->writeSequence.store(nextWriteSequence, std::memory_order_release);
+    }
+}
+
+void ShmChannel::stopWaiting() {
+    stopWaitingRequested.store(true);
+}
+
+int ShmChannel::poll(
+    std::vector<Vehicle>& lane_A,
+    std::vector<Vehicle>& lane_B,
+    std::vector<Vehicle>& lane_C,
+    std::vector<Vehicle>& lane_D
+) {
+    if (header == nullptr) {
+        return 0;
+    }
+
+    uint64_t first = header->readSequence.load(std::memory_order_relaxed);
+    uint64_t last = header->writeSequence.load(std::memory_order_acquire);
+    if (first == last) {
+        return 0;
+    }
+
+    if (last - first > maxBacklog) {
+        maxBacklog = last - first;
+    }
+
+    uint64_t now = epochNanoseconds();
+    int taken = 0;
+
+    for (uint64_t sequence = first; sequence != last; sequence++) {
+        const VehicleRecord& record = records[sequence & mask];
+        if (!record.isValid()) continue;
+
+        std::vector<Vehicle>* lane;
+        switch (record.road) {
+            case 'A': lane = &lane_A; break;
+            case 'B': lane = &lane_B; break;
+            case 'C': lane = &lane_C; break;
+            default:  lane = &lane_D; break;
+        }
+        lane->push_back(record.toVehicle());
+
+        uint64_t latency = now > record.timestampNs ? now - record.timestampNs : 0;
+        latencySumNs += latency;
+        if (latency > maxLatencyNs) maxLatencyNs = latency;
+        taken++;
+    }
+
+    // Commit only once the batch has been copied out, so the producer
+    // cannot reuse the slots and a restart resumes after this batch
+    header->readSequence.store(last, std::memory_order_release);
+    receivedCount += taken;
+    return taken;
+}
+
+uint64_t ShmChannel::getWriteSequence() const {
+    return header ? header->writeSequence.load() : 0;
+}
+
+uint64_t ShmChannel::getReadSequence() const {
+    return header ? header->readSequence.load() : 0;
+}
+
+void ShmChannel::printProducerStats() const {
+    std::cout << "\n--- Shared Memory Channel " << name << " (producer) ---" << std::endl;
+    std::cout << "Published:        " << publishedCount << std::endl;
+    std::cout << "Full-ring waits:  " << fullWaits << std::endl;
+    std::cout << "Next sequence:    " << getWriteSequence() << std::endl;
+}
+
+void ShmChannel::printConsumerStats() const {
+    std::cout << "\n--- Shared Memory Channel " << name << " (consumer) ---" << std::endl;
+    std::cout << "Resumed at seq:   " << resumedFrom << std::endl;
+    std::cout << "Received:         " << receivedCount << std::endl;
+    std::cout << "Next sequence:    " << getReadSequence()
+              << " (producer at " << getWriteSequence() << ")" << std::endl;
+    std::cout << "Max backlog:      " << maxBacklog << " records" << std::endl;
+    if (receivedCount > 0) {
+        std::cout << "Arrival latency:  avg " << latencySumNs / receivedCount / 1000.0
+                  << " us, max " << maxLatencyNs / 1000.0 << " us" << std::endl;
+    }
+}
@@ -0,0 +1,98 @@
+#ifndef SHMCHANNEL_H
+#define SHMCHANNEL_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "VehicleFeed.h"
+#include "VehicleRecord.h"
+
+// Vehicle channel between two processes on the same machine: a ring of
+// VehicleRecords in a POSIX shared memory object (shm_open + mmap). The
+// generator process publishes and the simulator process polls, one of each.
+//
+// Every record gets a sequence number from a counter that lives in the
+// shared header next to the consumer's committed position. Those counters
+// outlive either process, so a restarted generator carries on numbering
+// where it stopped, and a restarted simulator resumes right after the last
+// batch it took - nothing is lost or counted twice. The object stays until
+// ShmChannel::remove() (or deleting /dev/shm/<name>).
+//
+// POSIX only; open() fails elsewhere.
+class ShmChannel : public VehicleSink, public VehicleSource {
+private:
+    struct Header {
+        std::atomic<uint32_t> magic;        // set last, once the rest is valid
+        uint32_t version;
+        uint32_t recordSize;
+        uint32_t reserved;
+        uint64_t capacity;
+        // Each index on its own cache line (see SpscRing)
+        alignas(64) std::atomic<uint64_t> writeSequence;  // next sequence to publish
+        alignas(64) std::atomic<uint64_t> readSequence;   // next sequence to consume
+    };
+
+    static const uint32_t MAGIC = 0x4D485354;    // "TSHM"
+    static const uint32_t VERSION = 1;
+
+    std::string name;
+    Header* header;
+    VehicleRecord* records;
+    size_t mappedBytes;
+    uint64_t mask;
+
+    // Producer-side
+    uint64_t nextWriteSequence;     // published up to writeSequence, the rest pending
+    uint64_t cachedReadSequence;
+    long long publishedCount;
+    long long fullWaits;
+    std::atomic<bool> stopWaitingRequested;
+
+    // Consumer-side
+    uint64_t resumedFrom;
+    long long receivedCount;
+    uint64_t maxBacklog;
+    uint64_t latencySumNs;
+    uint64_t maxLatencyNs;
+
+    ShmChannel(const ShmChannel&);
+    ShmChannel& operator=(const ShmChannel&);
+
+public:
+    ShmChannel();
+    ~ShmChannel();
+
+    // Creates the channel, or attaches to an existing one (whose capacity
+    // then wins). Capacity is rounded up to a power of two.
+    bool open(const std::string& channelName, size_t capacity = 65536);
+    void close();
+    bool isOpen() const;
+    static bool remove(const std::string& channelName);
+
+    // Producer side: waits while the ring is full, so no arrival is dropped
+    bool publish(const std::string& plate, char road, int lane);
+    bool publishRecord(const VehicleRecord& record);
+    // Records become visible to the consumer in batches of up to 256;
+    // flush() publishes the rest
+    void flush();
+    // Makes a producer stuck on a full ring give up (safe from a signal
+    // handler)
+    void stopWaiting();
+
+    // Consumer side: takes everything published so far, then commits the
+    // new read position
+    int poll(
+        std::vector<Vehicle>& lane_A,
+        std::vector<Vehicle>& lane_B,
+        std::vector<Vehicle>& lane_C,
+        std::vector<Vehicle>& lane_D
+    );
+
+    uint64_t getWriteSequence() const;
+    uint64_t getReadSequence() const;
+
+    void printProducerStats() const;
+    void printConsumerStats() const;
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "SimulationClock.h"
+#include "TrafficManager.h"
+
+SimulationClock::SimulationClock(double loadInterval, double spawnInterval, double cycleInterval)
+    : loadInterval(loadInterval), spawnInterval(spawnInterval), cycleInterval(cycleInterval),
+      simTime(0.0), sinceLoad(0.0), sinceSpawn(0.0), sinceCycle(0.0), cycleCount(0),
+      source(nullptr), timingPhases(false)
+{
+}
+
+void SimulationClock::setSource(VehicleSource* vehicleSource) {
+    source = vehicleSource;
+}
+
+void SimulationClock::setPhaseTiming(bool on) {
+    timingPhases = on;
+    timings = StepTimings();
+}
+
+void SimulationClock::lap(float& slot, std::chrono::steady_clock::time_point& mark) {
+    if (!timingPhases) {
+        return;
+    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    slot = std::chrono::duration<float, std::micro>(now - mark).count();
+    mark = now;
+}
+
+void SimulationClock::step(TrafficManager& manager, float deltaTime) {
+    simTime += deltaTime;
+    sinceLoad += deltaTime;
+    sinceSpawn += deltaTime;
+    sinceCycle += deltaTime;
+    
+    std::chrono::steady_clock::time_point mark;
+    if (timingPhases) {
+        mark = std::chrono::steady_clock::now();
+    }
+    manager.setSimTime(simTime);
+    
+    // Subtract the interval instead of resetting so timers do not drift
+    // when the timestep does not divide the interval evenly
+    if (source != nullptr) {
+        source->advanceTo(simTime);
+        manager.loadVehiclesFrom(*source);
+    }
+    else if (loadInterval > 0.0 && sinceLoad >= loadInterval) {
+        manager.loadVehiclesFromFiles();
+        sinceLoad -= loadInterval;
+    }
+    lap(timings.loadMicros, mark);
+    
+    if (sinceSpawn >= spawnInterval) {
+        manager.spawnQueuedVehicles();
+        sinceSpawn -= spawnInterval;
+    }
+    lap(timings.spawnMicros, mark);
+    
+    manager.updateVehiclePositions(deltaTime);
+    lap(timings.updateMicros, mark);
+    
+    // Platoons discharge every step; actuated lights also decide their own
+    // phase lengths, and the cycle count then counts changes of the green
+    bool greenChanged = manager.updateSignals(deltaTime);
+    if (manager.isActuated()) {
+        if (greenChanged) {
+            cycleCount++;
+        }
+        sinceCycle = 0.0;
+    }
+    else if (sinceCycle >= cycleInterval) {
+        cycleCount++;
+        manager.processCycle();
+        sinceCycle -= cycleInterval;
+    }
+    lap(timings.signalsMicros, mark);
+    
+    manager.cleanupInactiveVehicles();
+    lap(timings.cleanupMicros, mark);
+}
+
+void SimulationClock::resumeAt(double simSeconds) {
+    simTime = simSeconds;
+}
+
+double SimulationClock::getSimTime() const {
+    return simTime;
+}
+
+int SimulationClock::getCycleCount() const {
+    return cycleCount;
+}
+
+const StepTimings& SimulationClock::getStepTimings() const {
+    return timings;
+}
@@ -0,0 +1,68 @@
+#ifndef SIMULATIONCLOCK_H
+#define SIMULATIONCLOCK_H
+
+#include <chrono>
+
+class TrafficManager;
+class VehicleSource;
+
+// Wall time of each phase of the last step, in microseconds. The signals
+// phase includes the light cycle.
+struct StepTimings {
+    float loadMicros;
+    float spawnMicros;
+    float updateMicros;
+    float signalsMicros;
+    float cleanupMicros;
+    
+    StepTimings()
+        : loadMicros(0.0f), spawnMicros(0.0f), updateMicros(0.0f),
+          signalsMicros(0.0f), cleanupMicros(0.0f) {}
+};
+
+// Drives a TrafficManager on simulated time instead of the wall clock.
+// Every step advances by a fixed timestep and fires the load, spawn and
+// light-cycle phases when their (simulated) intervals have elapsed, in the
+// same order simulator_sdl.cpp runs them each frame. A load interval of zero
+// or less disables polling the lane files (vehicles are added directly).
+// With a source set, it is drained every step instead, since polling an
+// in-memory feed costs nothing compared to reading the files. Under actuated
+// signal control the cycle interval is unused and the lights are updated
+// every step.
+class SimulationClock {
+private:
+    double loadInterval;
+    double spawnInterval;
+    double cycleInterval;
+    
+    double simTime;
+    double sinceLoad;
+    double sinceSpawn;
+    double sinceCycle;
+    int cycleCount;
+    VehicleSource* source;
+    bool timingPhases;
+    StepTimings timings;
+    
+    // Charges the time since mark to slot and moves mark on
+    void lap(float& slot, std::chrono::steady_clock::time_point& mark);
+    
+public:
+    SimulationClock(double loadInterval = 0.5, double spawnInterval = 0.1,
+                    double cycleInterval = 5.0);
+    
+    // Not owned; nullptr (the default) reads the lane files
+    void setSource(VehicleSource* vehicleSource);
+    // Off by default; when on, every step reads the clock between phases
+    void setPhaseTiming(bool on);
+    void step(TrafficManager& manager, float deltaTime);
+    // Continues from a restored manager's simulated time (see
+    // TrafficManager::getSimTime) instead of starting over at zero
+    void resumeAt(double simSeconds);
+    
+    double getSimTime() const;
+    int getCycleCount() const;
+    const StepTimings& getStepTimings() const;
+};
+
+#endif
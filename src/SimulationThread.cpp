@@ -0,0 +1,89 @@
+#include "SimulationThread.h"
+#include <chrono>
+
+SimulationThread::SimulationThread(TrafficManager& trafficManager, SimulationClock& simulationClock,
+                                   double timestepSeconds)
+    : manager(trafficManager), clock(simulationClock), timestep(timestepSeconds),
+      stopRequested(false), stepCount(0), resyncCount(0) {
+}
+
+SimulationThread::~SimulationThread() {
+    stop();
+}
+
+void SimulationThread::setStepHook(std::function<void(const TrafficManager&, double)> hook) {
+    stepHook = hook;
+}
+
+void SimulationThread::start() {
+    if (thread.joinable()) {
+        return;
+    }
+    stopRequested.store(false);
+    thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop() {
+    stopRequested.store(true);
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SimulationThread::run() {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::duration step = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(timestep));
+    const Clock::duration maxLag = std::chrono::milliseconds(250);
+
+    Clock::time_point nextStep = Clock::now();
+    long long steps = 0;
+
+    while (!stopRequested.load(std::memory_order_relaxed)) {
+        Clock::time_point stepStart = Clock::now();
+        clock.step(manager, static_cast<float>(timestep));
+        if (stepHook) {
+            stepHook(manager, clock.getSimTime());
+        }
+        steps++;
+
+        RenderState& state = states.writeSlot();
+        manager.captureRenderState(state);
+        state.step = steps;
+        state.stepMicros = std::chrono::duration<float, std::micro>(Clock::now() - stepStart).count();
+        const StepTimings& timings = clock.getStepTimings();
+        state.loadMicros = timings.loadMicros;
+        state.spawnMicros = timings.spawnMicros;
+        state.updateMicros = timings.updateMicros;
+        state.signalsMicros = timings.signalsMicros;
+        state.cleanupMicros = timings.cleanupMicros;
+        states.publish();
+        stepCount.store(steps, std::memory_order_relaxed);
+
+        nextStep += step;
+        Clock::time_point now = Clock::now();
+        if (now < nextStep) {
+            std::this_thread::sleep_until(nextStep);
+        }
+        else if (now - nextStep > maxLag) {
+            nextStep = now;
+            resyncCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool SimulationThread::update() {
+    return states.update();
+}
+
+const RenderState& SimulationThread::getState() const {
+    return states.readSlot();
+}
+
+long long SimulationThread::getStepCount() const {
+    return stepCount.load(std::memory_order_relaxed);
+}
+
+long long SimulationThread::getResyncCount() const {
+    return resyncCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include <thread>
+#include <atomic>
+#include <functional>
+#include "TrafficManager.h"
+#include "SimulationClock.h"
+#include "TripleBuffer.h"
+
+// Runs a SimulationClock on its own thread with a fixed timestep, paced to
+// real time, and publishes a RenderState after every step through a triple
+// buffer. The display thread picks up the newest state whenever it draws,
+// so a slow frame only skips pictures; the simulation itself always advances
+// by the same timestep and gives the same result however fast the window
+// is. If the simulation falls more than a quarter second behind real time
+// it stops trying to catch up (counted as a resync) instead of running ever
+// longer bursts of steps.
+//
+// While the thread runs, the manager and clock belong to it: the caller only
+// reads states, and touches the manager again after stop().
+class SimulationThread {
+private:
+    TrafficManager& manager;
+    SimulationClock& clock;
+    double timestep;
+    std::function<void(const TrafficManager&, double)> stepHook;
+
+    TripleBuffer<RenderState> states;
+    std::thread thread;
+    std::atomic<bool> stopRequested;
+    std::atomic<long long> stepCount;
+    std::atomic<long long> resyncCount;
+
+    void run();
+
+    SimulationThread(const SimulationThread&);
+    SimulationThread& operator=(const SimulationThread&);
+
+public:
+    SimulationThread(TrafficManager& trafficManager, SimulationClock& simulationClock,
+                     double timestepSeconds = 1.0 / 60.0);
+    ~SimulationThread();
+
+    // Called on the simulation thread after every step with the simulated
+    // time, e.g. for a MetricsExporter. Set before start().
+    void setStepHook(std::function<void(const TrafficManager&, double)> hook);
+
+    void start();
+    // Finishes the current step and joins the thread
+    void stop();
+
+    // Display side: moves to the newest published state, false if there is
+    // none since the last call. getState() stays valid until the next update().
+    bool update();
+    const RenderState& getState() const;
+
+    long long getStepCount() const;
+    long long getResyncCount() const;
+};
+
+#endif
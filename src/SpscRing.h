@@ -0,0 +1,92 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Each side owns one index and only reads the other's, so a push or
+// pop is a couple of atomic loads/stores and never blocks or allocates.
+// The capacity is rounded up to a power of two.
+template <typename T>
+class SpscRing {
+private:
+    // Keep the two indices on separate cache lines so the threads do not
+    // keep stealing the line from each other
+    static const size_t CACHE_LINE = 64;
+
+    T* buffer;
+    size_t capacity;
+    size_t mask;
+
+    alignas(CACHE_LINE) std::atomic<size_t> head;   // next slot to pop, written by consumer
+    alignas(CACHE_LINE) std::atomic<size_t> tail;   // next slot to push, written by producer
+    size_t cachedHead;                              // producer's last view of head
+
+    SpscRing(const SpscRing&);
+    SpscRing& operator=(const SpscRing&);
+
+public:
+    explicit SpscRing(size_t minCapacity)
+        : buffer(nullptr), capacity(1), mask(0), head(0), tail(0), cachedHead(0)
+    {
+        while (capacity < minCapacity) {
+            capacity <<= 1;
+        }
+        mask = capacity - 1;
+        buffer = static_cast<T*>(::operator new(sizeof(T) * capacity));
+    }
+
+    ~SpscRing() {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_relaxed);
+        for (; h != t; h++) {
+            buffer[h & mask].~T();
+        }
+        ::operator delete(buffer);
+    }
+
+    // Producer side. Returns false when the ring is full.
+    bool tryPush(T&& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == capacity) {
+                return false;
+            }
+        }
+        new (buffer + (t & mask)) T(std::move(item));
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Hands every item published so far to consume(T&&) and
+    // releases the slots with a single store; returns how many were taken.
+    template <typename Consumer>
+    size_t drain(Consumer consume) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+
+        for (size_t i = h; i != t; i++) {
+            T* slot = buffer + (i & mask);
+            consume(std::move(*slot));
+            slot->~T();
+        }
+
+        head.store(t, std::memory_order_release);
+        return t - h;
+    }
+
+    // Approximate when called while the other side is running
+    size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+    size_t getCapacity() const {
+        return capacity;
+    }
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threadCount)
+    : pendingTasks(0), nextQueue(0), stopping(false)
+{
+    if (threadCount <= 0) {
+        threadCount = std::thread::hardware_concurrency();
+        if (threadCount <= 0) threadCount = 1;
+    }
+
+    for (int i = 0; i < threadCount; i++) {
+        queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+    }
+    for (int i = 0; i < threadCount; i++) {
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(const std::function<void()>& task) {
+    unsigned index = nextQueue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(task);
+    }
+
+    // Count the task before waking anyone so a worker going to sleep
+    // cannot miss it
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        pendingTasks++;
+    }
+    wakeCondition.notify_one();
+}
+
+bool ThreadPool::takeTask(int self, std::function<void()>& task) {
+    int count = queues.size();
+
+    // Own queue first, newest task (still warm in cache)
+    {
+        WorkQueue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            pendingTasks--;
+            return true;
+        }
+    }
+
+    // Steal the oldest task from someone else
+    for (int offset = 1; offset < count; offset++) {
+        WorkQueue& victim = *queues[(self + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pendingTasks--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::workerLoop(int self) {
+    std::function<void()> task;
+
+    while (true) {
+        if (takeTask(self, task)) {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        wakeCondition.wait(lock, [this] { return stopping || pendingTasks > 0; });
+        if (stopping && pendingTasks == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& body) {
+    if (count <= 0) return;
+
+    // A few chunks per thread leaves room for stealing without paying task
+    // overhead per index
+    int threads = workers.size();
+    int chunks = threads * 4;
+    if (chunks > count) chunks = count;
+    int chunkSize = (count + chunks - 1) / chunks;
+
+    std::mutex doneMutex;
+    std::condition_variable doneCondition;
+    int remaining = 0;
+
+    for (int begin = 0; begin < count; begin += chunkSize) {
+        remaining++;
+    }
+
+    for (int begin = 0; begin < count; begin += chunkSize) {
+        int end = (begin + chunkSize < count) ? begin + chunkSize : count;
+        submit([begin, end, &body, &doneMutex, &doneCondition, &remaining] {
+            for (int i = begin; i < end; i++) {
+                body(i);
+            }
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (--remaining == 0) {
+                doneCondition.notify_one();
+            }
+        });
+    }
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCondition.wait(lock, [&remaining] { return remaining == 0; });
+}
+
+int ThreadPool::getThreadCount() const {
+    return workers.size();
+}
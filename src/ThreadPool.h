@@ -0,0 +1,49 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+
+// Fixed-size pool of worker threads with one task deque per worker. A worker
+// takes new work from the back of its own deque and, when that is empty,
+// steals from the front of the others, so uneven tasks (a congested junction
+// next to an empty one) still keep every core busy.
+class ThreadPool {
+private:
+    struct WorkQueue {
+        std::deque<std::function<void()> > tasks;
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue> > queues;
+    std::vector<std::thread> workers;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<int> pendingTasks;
+    std::atomic<unsigned> nextQueue;
+    bool stopping;
+
+    bool takeTask(int self, std::function<void()>& task);
+    void workerLoop(int self);
+
+public:
+    // threadCount <= 0 uses one thread per hardware core
+    explicit ThreadPool(int threadCount = 0);
+    ~ThreadPool();
+
+    void submit(const std::function<void()>& task);
+
+    // Runs body(0) .. body(count - 1) on the pool and returns when all are done
+    void parallelFor(int count, const std::function<void(int)>& body);
+
+    int getThreadCount() const;
+};
+
+#endif
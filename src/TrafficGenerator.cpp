@@ -1,15 +1,101 @@
 #include "TrafficGenerator.h"
 #include <iostream>
+#include <cstdlib>
 #include <fstream>
 #include <ctime>
-#include <windows.h>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <sys/stat.h>
 
 TrafficGenerator::TrafficGenerator():
     randomEngine(std::time(nullptr)),
     roadDistribution(0, 99),     
     laneDistribution(1, 3),      
-    timeDistribution(0.5, 2.0)    
-{}
+    timeDistribution(0.5, 2.0),
+    sink(nullptr),
+    fileFormat(LANE_FORMAT_TEXT),
+    quiet(false),
+    stopRequested(false),
+    generatedCount(0),
+    generateLimit(0),
+    summaryInterval(1.0)
+{
+    for (int i = 0; i < 4; i++) {
+        roadRates[i] = 0.0;
+        roadCounts[i] = 0;
+    }
+}
+
+void TrafficGenerator::setSink(VehicleSink* vehicleSink) {
+    sink = vehicleSink;
+}
+
+void TrafficGenerator::setFileFormat(LaneFileFormat format) {
+    fileFormat = format;
+}
+
+void TrafficGenerator::setQuiet(bool enabled) {
+    quiet = enabled;
+}
+
+bool TrafficGenerator::setPacing(double minSeconds, double maxSeconds) {
+    // uniform_real_distribution is undefined for min > max
+    if (!(minSeconds >= 0.0 && minSeconds <= maxSeconds)) {
+        return false;
+    }
+    timeDistribution = std::uniform_real_distribution<double>(minSeconds, maxSeconds);
+    return true;
+}
+
+bool TrafficGenerator::parsePacing(const std::string& range, double& minSeconds, double& maxSeconds) {
+    size_t comma = range.find(',');
+    std::string first = range.substr(0, comma);
+    std::string second = (comma == std::string::npos) ? first : range.substr(comma + 1);
+
+    char* end = nullptr;
+    double low = std::strtod(first.c_str(), &end);
+    if (first.empty() || *end != '\0') return false;
+    double high = std::strtod(second.c_str(), &end);
+    if (second.empty() || *end != '\0') return false;
+
+    if (!(low >= 0.0 && low <= high)) {
+        return false;
+    }
+    minSeconds = low;
+    maxSeconds = high;
+    return true;
+}
+
+void TrafficGenerator::setSeed(unsigned seed) {
+    randomEngine.seed(seed);
+    roadDistribution.reset();
+    laneDistribution.reset();
+    timeDistribution.reset();
+}
+
+void TrafficGenerator::setLimit(long long vehicles) {
+    generateLimit = vehicles;
+}
+
+void TrafficGenerator::setRoadRates(double rateA, double rateB, double rateC, double rateD) {
+    roadRates[0] = rateA > 0.0 ? rateA : 0.0;
+    roadRates[1] = rateB > 0.0 ? rateB : 0.0;
+    roadRates[2] = rateC > 0.0 ? rateC : 0.0;
+    roadRates[3] = rateD > 0.0 ? rateD : 0.0;
+}
+
+void TrafficGenerator::setSummaryInterval(double seconds) {
+    summaryInterval = seconds > 0.0 ? seconds : 1.0;
+}
+
+void TrafficGenerator::requestStop() {
+    stopRequested.store(true);
+}
+
+long long TrafficGenerator::getGeneratedCount() const {
+    return generatedCount;
+}
 
 std::string TrafficGenerator::generateLicensePlate() {
     const char* provinces[] = {"BA", "GA", "LU", "PR", "KA", "SU", "SE"};
@@ -71,16 +157,21 @@ int TrafficGenerator::selectRandomLane() {
 }
 
 bool TrafficGenerator::writeVehicleToFile(const std::string& plate, char road, int lane) {
-    std::string filename;
-    
-    switch(road) {
-        case 'A': filename = "lane_A.txt"; break;
-        case 'B': filename = "lane_B.txt"; break;
-        case 'C': filename = "lane_C.txt"; break;
-        case 'D': filename = "lane_D.txt"; break;
-        default: return false;
+    if (sink != nullptr) {
+        // One vehicle at a time here, so make each one visible right away
+        bool published = sink->publish(plate, road, lane);
+        sink->flush();
+        return published;
+    }
+    if (road < 'A' || road > 'D') {
+        return false;
+    }
+    if (fileFormat == LANE_FORMAT_BINARY) {
+        return writeBinaryRecord(plate, road, lane);
     }
     
+    std::string filename = laneFileName(road, LANE_FORMAT_TEXT);
+    
     std::ofstream file(filename, std::ios::app);
     
     if (!file.is_open()) {
@@ -94,12 +185,38 @@ bool TrafficGenerator::writeVehicleToFile(const std::string& plate, char road, i
     return true;
 }
 
+bool TrafficGenerator::writeBinaryRecord(const std::string& plate, char road, int lane) {
+    std::string filename = laneFileName(road, LANE_FORMAT_BINARY);
+    
+    std::ofstream file(filename, std::ios::app | std::ios::binary);
+    
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << filename << std::endl;
+        return false;
+    }
+    
+    // A new (or just emptied) file starts with the format header
+    file.seekp(0, std::ios::end);
+    if (file.tellp() == 0) {
+        VehicleFileHeader header = VehicleFileHeader::make();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    
+    VehicleRecord record = VehicleRecord::make(plate, road, lane, epochNanoseconds());
+    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    
+    return file.good();
+}
+
 void TrafficGenerator::generateSingleVehicle() {
     std::string plate = generateLicensePlate();
     char road = selectRandomRoad();
     int lane = selectRandomLane();
     
     if (writeVehicleToFile(plate, road, lane)) {
+        generatedCount++;
+        if (quiet) return;
+        
         std::cout << "Generated: " << plate 
                   << " -> Road " << road 
                   << " Lane " << lane;
@@ -119,31 +236,42 @@ void TrafficGenerator::generateSingleVehicle() {
 }
 
 void TrafficGenerator::run() {
-    int vehicleCount = 0;
-    
-    std::cout << "\n╔════════════════════════════════════════════╗" << std::endl;
-    std::cout << "║   Traffic Generator Started (3-Lane)      ║" << std::endl;
-    std::cout << "╚════════════════════════════════════════════╝" << std::endl;
-    std::cout << "\n📊 Traffic Distribution:" << std::endl;
-    std::cout << "   Road A (Priority): 40% of traffic" << std::endl;
-    std::cout << "   Roads B, C, D:     20% each" << std::endl;
-    std::cout << "\n🛣️  Lane Distribution:" << std::endl;
-    std::cout << "   Lane 1 (Right):  20% - 🟢 FREE FLOW" << std::endl;
-    std::cout << "   Lane 2 (Straight): 60% - 🔴 CONTROLLED" << std::endl;
-    std::cout << "   Lane 3 (Left):   20% - 🟢 FREE FLOW" << std::endl;
-    std::cout << "\nPress Ctrl+C to stop\n" << std::endl;
-    
-    while (true) {
+    if (roadRates[0] + roadRates[1] + roadRates[2] + roadRates[3] > 0.0) {
+        runAtRates();
+        return;
+    }
+    
+    if (!quiet) {
+        std::cout << "\n╔════════════════════════════════════════════╗" << std::endl;
+        std::cout << "║   Traffic Generator Started (3-Lane)      ║" << std::endl;
+        std::cout << "╚════════════════════════════════════════════╝" << std::endl;
+        std::cout << "\n📊 Traffic Distribution:" << std::endl;
+        std::cout << "   Road A (Priority): 40% of traffic" << std::endl;
+        std::cout << "   Roads B, C, D:     20% each" << std::endl;
+        std::cout << "\n🛣️  Lane Distribution:" << std::endl;
+        std::cout << "   Lane 1 (Right):  20% - 🟢 FREE FLOW" << std::endl;
+        std::cout << "   Lane 2 (Straight): 60% - 🔴 CONTROLLED" << std::endl;
+        std::cout << "   Lane 3 (Left):   20% - 🟢 FREE FLOW" << std::endl;
+        std::cout << "\nPress Ctrl+C to stop\n" << std::endl;
+    }
+    
+    while (!stopRequested.load(std::memory_order_relaxed)
+           && (generateLimit <= 0 || generatedCount < generateLimit)) {
         double waitTime = timeDistribution(randomEngine);
-        Sleep(static_cast<int>(waitTime * 1000));
+        if (waitTime > 0.0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(
+                static_cast<long long>(waitTime * 1000000)));
+        }
         
         std::string plate = generateLicensePlate();
         char road = selectRandomRoad();
         int lane = selectRandomLane();
         
         if (writeVehicleToFile(plate, road, lane)) {
-            vehicleCount++;
-            std::cout << "[" << vehicleCount << "] " << plate 
+            generatedCount++;
+            if (quiet) continue;
+            
+            std::cout << "[" << generatedCount << "] " << plate 
                       << " → Road " << road << "L" << lane;
             
             if (lane == 1) {
@@ -155,8 +283,189 @@ void TrafficGenerator::run() {
             }
             std::cout << std::endl;
         }
-        else {
+        else if (!stopRequested.load(std::memory_order_relaxed)) {
             std::cerr << "Error writing vehicle to file!" << std::endl;
         }
     }
-}
\ No newline at end of file
+}
+
+// Buffers a vehicle for its road; a sink gets it directly and is flushed
+// with the rest of the batch
+bool TrafficGenerator::emitVehicle(const std::string& plate, char road, int lane) {
+    if (sink != nullptr) {
+        return sink->publish(plate, road, lane);
+    }
+    
+    int index = road - 'A';
+    std::vector<char>& buffer = laneBuffers[index];
+    
+    if (fileFormat == LANE_FORMAT_BINARY) {
+        VehicleRecord record = VehicleRecord::make(plate, road, lane, epochNanoseconds());
+        const char* bytes = reinterpret_cast<const char*>(&record);
+        buffer.insert(buffer.end(), bytes, bytes + sizeof(record));
+    }
+    else {
+        buffer.insert(buffer.end(), plate.begin(), plate.end());
+        buffer.push_back(',');
+        buffer.push_back(road);
+        buffer.push_back(',');
+        buffer.push_back(static_cast<char>('0' + lane));
+        buffer.push_back('\n');
+    }
+    
+    if (buffer.size() >= (1 << 20)) {
+        flushLane(index);
+    }
+    return true;
+}
+
+void TrafficGenerator::flushLane(int roadIndex) {
+    std::vector<char>& buffer = laneBuffers[roadIndex];
+    if (buffer.empty()) return;
+    
+    std::string filename = laneFileName('A' + roadIndex, fileFormat);
+    std::ofstream& stream = laneStreams[roadIndex];
+    if (!stream.is_open()) {
+        stream.open(filename, std::ios::app | std::ios::binary);
+        if (!stream.is_open()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            buffer.clear();
+            return;
+        }
+    }
+    
+    // The simulator empties lane files after reading them; a binary file
+    // needs its header again before the next batch
+    if (fileFormat == LANE_FORMAT_BINARY) {
+        struct stat info;
+        if (stat(filename.c_str(), &info) == 0 && info.st_size == 0) {
+            VehicleFileHeader header = VehicleFileHeader::make();
+            stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+    }
+    
+    stream.write(buffer.data(), buffer.size());
+    stream.flush();
+    buffer.clear();
+}
+
+void TrafficGenerator::flushOutputs() {
+    if (sink != nullptr) {
+        sink->flush();
+        return;
+    }
+    for (int i = 0; i < 4; i++) {
+        flushLane(i);
+    }
+}
+
+void TrafficGenerator::closeStreams() {
+    for (int i = 0; i < 4; i++) {
+        if (laneStreams[i].is_open()) {
+            laneStreams[i].close();
+        }
+    }
+}
+
+void TrafficGenerator::printSummary(double elapsed, double interval,
+                                    const long long* previous, double behind) {
+    const char roads[] = {'A', 'B', 'C', 'D'};
+    long long intervalTotal = 0;
+    for (int i = 0; i < 4; i++) {
+        intervalTotal += roadCounts[i] - previous[i];
+    }
+    
+    std::cout << "[" << std::fixed << std::setprecision(1) << std::setw(7) << elapsed << " s] "
+              << generatedCount << " total, "
+              << std::setprecision(0) << intervalTotal / interval << " v/s (";
+    for (int i = 0; i < 4; i++) {
+        std::cout << (i ? " " : "") << roads[i] << " " << (roadCounts[i] - previous[i]) / interval;
+    }
+    std::cout << ")";
+    if (behind > 0.001) {
+        std::cout << std::setprecision(3) << ", behind schedule by " << behind << " s";
+    }
+    std::cout << std::endl;
+    std::cout.unsetf(std::ios::fixed);
+    std::cout << std::setprecision(6);
+}
+
+void TrafficGenerator::runAtRates() {
+    double totalRate = roadRates[0] + roadRates[1] + roadRates[2] + roadRates[3];
+    
+    // The four Poisson streams together form one stream at the total rate,
+    // with each arrival landing on a road in proportion to its rate
+    std::exponential_distribution<double> gapDistribution(totalRate);
+    std::uniform_real_distribution<double> roadPick(0.0, totalRate);
+    
+    std::cout << "Rate mode: " << totalRate << " vehicles/s (A " << roadRates[0]
+              << ", B " << roadRates[1] << ", C " << roadRates[2] << ", D " << roadRates[3]
+              << "), Poisson arrivals" << std::endl;
+    
+    auto start = std::chrono::steady_clock::now();
+    auto secondsSinceStart = [&start]() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start
+        ).count() / 1000000.0;
+    };
+    
+    double nextArrival = gapDistribution(randomEngine);
+    double nextSummary = summaryInterval;
+    double lastSummary = 0.0;
+    double behind = 0.0;
+    long long previousCounts[4] = {0, 0, 0, 0};
+    
+    while (!stopRequested.load(std::memory_order_relaxed)
+           && (generateLimit <= 0 || generatedCount < generateLimit)) {
+        double now = secondsSinceStart();
+        
+        if (nextArrival > now) {
+            // Caught up: hand the batch over and sleep until the next
+            // arrival, waking at least every 50 ms to notice a stop request
+            flushOutputs();
+            double wake = nextArrival < nextSummary ? nextArrival : nextSummary;
+            double nap = wake - now;
+            if (nap > 0.05) nap = 0.05;
+            if (nap > 0.0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(
+                    static_cast<long long>(nap * 1000000)));
+            }
+            now = secondsSinceStart();
+        }
+        
+        // Everything due by now goes out as one batch
+        for (int batch = 0; nextArrival <= now && batch < 65536; batch++) {
+            if (generateLimit > 0 && generatedCount >= generateLimit) break;
+            
+            double pick = roadPick(randomEngine);
+            int road = 0;
+            while (road < 3 && pick >= roadRates[road]) {
+                pick -= roadRates[road];
+                road++;
+            }
+            
+            if (emitVehicle(generateLicensePlate(), 'A' + road, selectRandomLane())) {
+                generatedCount++;
+                roadCounts[road]++;
+            }
+            nextArrival += gapDistribution(randomEngine);
+        }
+        
+        behind = now - nextArrival;
+        if (now >= nextSummary) {
+            flushOutputs();
+            printSummary(now, now - lastSummary, previousCounts, behind);
+            for (int i = 0; i < 4; i++) previousCounts[i] = roadCounts[i];
+            lastSummary = now;
+            while (nextSummary <= now) nextSummary += summaryInterval;
+        }
+    }
+    
+    flushOutputs();
+    closeStreams();
+    
+    double elapsed = secondsSinceStart();
+    if (elapsed > lastSummary) {
+        printSummary(elapsed, elapsed - lastSummary, previousCounts, behind);
+    }
+}
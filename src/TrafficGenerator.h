@@ -3,6 +3,11 @@
 
 #include <string>
 #include <random>
+#include <atomic>
+#include <fstream>
+#include <vector>
+#include "VehicleFeed.h"
+#include "VehicleRecord.h"
 
 class TrafficGenerator {
 private:
@@ -11,15 +16,66 @@ private:
     std::uniform_int_distribution<int> laneDistribution;
     std::uniform_real_distribution<double> timeDistribution;
     
+    VehicleSink* sink;
+    LaneFileFormat fileFormat;
+    bool quiet;
+    std::atomic<bool> stopRequested;
+    long long generatedCount;
+    long long generateLimit;
+    
+    // Rate mode: Poisson arrivals at a target rate per road
+    double roadRates[4];
+    double summaryInterval;
+    std::ofstream laneStreams[4];
+    std::vector<char> laneBuffers[4];
+    long long roadCounts[4];
+    
     std::string generateLicensePlate();
     char selectRandomRoad();
     int selectRandomLane();
     bool writeVehicleToFile(const std::string& plate, char road, int lane);
+    bool writeBinaryRecord(const std::string& plate, char road, int lane);
+    
+    void runAtRates();
+    bool emitVehicle(const std::string& plate, char road, int lane);
+    void flushOutputs();
+    void flushLane(int roadIndex);
+    void closeStreams();
+    void printSummary(double elapsed, double interval, const long long* previous, double behind);
     
 public:
     TrafficGenerator();
+    
+    // Publish to a sink (not owned) instead of appending to the lane files
+    void setSink(VehicleSink* vehicleSink);
+    // Text lines in lane_X.txt (default) or binary records in lane_X.bin
+    void setFileFormat(LaneFileFormat format);
+    // Suppress the per-vehicle console output
+    void setQuiet(bool enabled);
+    // Seconds to wait between vehicles (default 0.5 - 2.0); 0,0 runs flat out.
+    // Needs 0 <= min <= max; returns false and keeps the old pacing otherwise.
+    bool setPacing(double minSeconds, double maxSeconds);
+    // Parses "<min>,<max>" or "<seconds>" as given to --wait; false unless
+    // both are numbers with 0 <= min <= max
+    static bool parsePacing(const std::string& range, double& minSeconds, double& maxSeconds);
+    // Seeds plates, roads, lanes and waits (default: the current time). The
+    // sequence of vehicles is then repeatable; when the simulator picks them
+    // up still depends on its polling, so record a trace for exact replays.
+    void setSeed(unsigned seed);
+    // Stop run() after this many vehicles (0 = no limit)
+    void setLimit(long long vehicles);
+    // Switches run() to rate mode: Poisson arrivals with these mean rates
+    // (vehicles/s per road), written in batches to streams that stay open,
+    // with a summary line every summaryInterval seconds instead of a line
+    // per vehicle. All zero returns to the paced mode.
+    void setRoadRates(double rateA, double rateB, double rateC, double rateD);
+    void setSummaryInterval(double seconds);
+    
     void generateSingleVehicle();
+    // Generates until requestStop() is called (from any thread)
     void run();
+    void requestStop();
+    long long getGeneratedCount() const;
 };
 
 #endif
\ No newline at end of file
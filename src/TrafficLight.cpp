@@ -38,6 +38,10 @@ void TrafficLight::switchToNextLane() {
     }
 }
 
+void TrafficLight::switchTo(char lane){
+    currentLane = lane;
+}
+
 void TrafficLight::activatePriorityMode(){
     priorityMode = true;
     currentLane = 'A'; 
@@ -50,6 +54,11 @@ void TrafficLight::deactivatePriorityMode(){
 bool TrafficLight::isPriorityMode() const{
     return priorityMode;
 }
+
+void TrafficLight::restore(char lane, bool priority){
+    currentLane = lane;
+    priorityMode = priority;
+}
 void TrafficLight::display() const {
     std::cout << "Traffic Light Status:" << std::endl;
     std::cout << "  Lane A: " << (currentLane == 'A' ? "GREEN" : "RED") << std::endl;
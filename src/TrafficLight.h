@@ -18,9 +18,13 @@ public:
     char getCurrentLane() const;
     bool isGreen(char lane) const;
     void switchToNextLane();
+    // Gives the green straight to a road (actuated control skips roads)
+    void switchTo(char lane);
     void activatePriorityMode();
     void deactivatePriorityMode();
     bool isPriorityMode() const;
+    // Puts the light back into a saved state (TrafficManager snapshots)
+    void restore(char lane, bool priority);
 
     void display() const;
 };
@@ -1,12 +1,17 @@
 #include "TrafficManager.h"
 #include "TrafficLight.h"
 #include "Vehicle.h"
-#include "SDLRenderer.h"
 #include <iostream>
 #include <algorithm>
 #include <cmath>
-
-TrafficManager::TrafficManager() : totalVehiclesProcessed(0) {
+#include <limits>
+
+TrafficManager::TrafficManager()
+    : signalControl(SIGNAL_FIXED), dischargeMode(DISCHARGE_SINGLE), greenElapsed(0.0f), sinceDischarge(0.0f), phaseReleases(0),
+      dischargeStarted(false),
+      totalVehiclesProcessed(0), verbose(true), maxActivePerRoad(15), retiredSinceCleanup(0),
+      collectExits(false), laneFileFormat(LANE_FORMAT_TEXT), traceRecorder(nullptr),
+      simTime(0.0) {
 }
 
 Queue<Vehicle>& TrafficManager::getLaneQueue(char road) {
@@ -39,6 +44,73 @@ const std::vector<AnimatedVehicle>& TrafficManager::getActiveVehicles(char road)
     }
 }
 
+KinematicsArrays& TrafficManager::getKinematics(char road) {
+    switch(road) {
+        case 'A': return kinematicsA;
+        case 'B': return kinematicsB;
+        case 'C': return kinematicsC;
+        case 'D': return kinematicsD;
+        default: return kinematicsA;
+    }
+}
+
+const KinematicsArrays& TrafficManager::getKinematics(char road) const {
+    switch(road) {
+        case 'A': return kinematicsA;
+        case 'B': return kinematicsB;
+        case 'C': return kinematicsC;
+        case 'D': return kinematicsD;
+        default: return kinematicsA;
+    }
+}
+
+LaneIndex& TrafficManager::getLaneOrder(char road, int lane) {
+    int slot = (lane >= 1 && lane <= 3) ? lane - 1 : 0;
+    switch(road) {
+        case 'A': return laneOrderA[slot];
+        case 'B': return laneOrderB[slot];
+        case 'C': return laneOrderC[slot];
+        case 'D': return laneOrderD[slot];
+        default: return laneOrderA[slot];
+    }
+}
+
+const LaneIndex& TrafficManager::getLaneOrder(char road, int lane) const {
+    return const_cast<TrafficManager*>(this)->getLaneOrder(road, lane);
+}
+
+// Distance travelled along the road's direction of motion
+float TrafficManager::travelProgress(char road, float x, float y) {
+    switch(road) {
+        case 'A': return x;     // left to right
+        case 'B': return y;     // top to bottom
+        case 'C': return -x;    // right to left
+        case 'D': return -y;    // bottom to top
+        default: return x;
+    }
+}
+
+// Pushes a freshly spawned vehicle back so it starts at least one spacing
+// behind the last car in its lane instead of on top of it
+void TrafficManager::keepSpawnGap(Vehicle& vehicle, char road, int leaderIndex) {
+    const float spacing = 40.0f;
+    
+    float leaderX, leaderY;
+    getKinematics(road).positionAt(leaderIndex, leaderX, leaderY);
+    float leaderProgress = travelProgress(road, leaderX, leaderY);
+    float overlap = travelProgress(road, vehicle.getX(), vehicle.getY()) - (leaderProgress - spacing);
+    if (overlap <= 0.0f) {
+        return;
+    }
+    
+    switch(road) {
+        case 'A': vehicle.setPosition(vehicle.getX() - overlap, vehicle.getY()); break;
+        case 'B': vehicle.setPosition(vehicle.getX(), vehicle.getY() - overlap); break;
+        case 'C': vehicle.setPosition(vehicle.getX() + overlap, vehicle.getY()); break;
+        case 'D': vehicle.setPosition(vehicle.getX(), vehicle.getY() + overlap); break;
+    }
+}
+
 // Check if a lane is free-flow (lanes 1 and 3 for turning)
 bool TrafficManager::isFreeFlowLane(int lane) const {
     return (lane == 1 || lane == 3);  // Lane 1 = right turn, Lane 3 = left turn
@@ -81,7 +153,8 @@ void TrafficManager::initializeVehiclePosition(Vehicle& vehicle, char road, int
     }
 }
 
-void TrafficManager::setVehicleWaitingPosition(Vehicle& vehicle, char road, int queuePosition) {
+// Place queuePosition cars back from the stop line of a road's lane
+void TrafficManager::waitingTarget(char road, int lane, int queuePosition, float& targetX, float& targetY) {
     const int centerX = 450;
     const int centerY = 350;
     const int roadWidth = 180;
@@ -89,7 +162,6 @@ void TrafficManager::setVehicleWaitingPosition(Vehicle& vehicle, char road, int
     const int carLength = 35;  // Car length for proper spacing
     const int stopDistance = roadWidth/2 + 20;
     
-    int lane = vehicle.getLaneNumber();
     int laneOffset = (lane - 1) * laneWidth + laneWidth/2;
     
     // ALL lanes converge to the stop line
@@ -97,28 +169,31 @@ void TrafficManager::setVehicleWaitingPosition(Vehicle& vehicle, char road, int
     
     if (road == 'A') {
         // Horizontal road: maintain lane Y position, cars queue backward from stop line
-        int laneY = centerY - roadWidth/2 + laneOffset;
-        float targetX = centerX - stopDistance - queuePosition * carLength;
-        vehicle.setTarget(targetX, laneY);
+        targetX = centerX - stopDistance - queuePosition * carLength;
+        targetY = centerY - roadWidth/2 + laneOffset;
     }
     else if (road == 'B') {
         // Vertical road: maintain lane X position, cars queue upward from stop line
-        int laneX = centerX - roadWidth/2 + laneOffset;
-        float targetY = centerY - stopDistance - queuePosition * carLength;
-        vehicle.setTarget(laneX, targetY);
+        targetX = centerX - roadWidth/2 + laneOffset;
+        targetY = centerY - stopDistance - queuePosition * carLength;
     }
     else if (road == 'C') {
         // Horizontal road: maintain lane Y position, cars queue forward from stop line
-        int laneY = centerY - roadWidth/2 + laneOffset;
-        float targetX = centerX + stopDistance + queuePosition * carLength;
-        vehicle.setTarget(targetX, laneY);
+        targetX = centerX + stopDistance + queuePosition * carLength;
+        targetY = centerY - roadWidth/2 + laneOffset;
     }
-    else if (road == 'D') {
+    else {
         // Vertical road: maintain lane X position, cars queue downward from stop line
-        int laneX = centerX - roadWidth/2 + laneOffset;
-        float targetY = centerY + stopDistance + queuePosition * carLength;
-        vehicle.setTarget(laneX, targetY);
+        targetX = centerX - roadWidth/2 + laneOffset;
+        targetY = centerY + stopDistance + queuePosition * carLength;
     }
+}
+
+void TrafficManager::setVehicleWaitingPosition(Vehicle& vehicle, char road, int queuePosition) {
+    int lane = vehicle.getLaneNumber();
+    float targetX, targetY;
+    waitingTarget(road, lane, queuePosition, targetX, targetY);
+    vehicle.setTarget(targetX, targetY);
     
     vehicle.setMoving(true);
     vehicle.setSpeed(80.0f);
@@ -136,8 +211,14 @@ void TrafficManager::addVehicle(const Vehicle& vehicle) {
     char road = vehicle.getRoadName();
     int lane = vehicle.getLaneNumber();
     
+    Vehicle arrived(vehicle);
+    arrived.setEntryTime(simTime);
+    metrics.at(road, lane).arrived++;
+    
     Queue<Vehicle>& targetQueue = getLaneQueue(road);
-    targetQueue.enqueue(vehicle);
+    targetQueue.enqueue(std::move(arrived));
+    
+    if (!verbose) return;
     
     std::cout << "Vehicle " << vehicle.getLicensePlate()
               << " added to Road " << road << " Lane " << lane;
@@ -154,31 +235,40 @@ void TrafficManager::spawnQueuedVehicles() {
     for (char road : roads) {
         Queue<Vehicle>& queue = getLaneQueue(road);
         std::vector<AnimatedVehicle>& activeVehicles = getActiveVehicles(road);
+        KinematicsArrays& kinematics = getKinematics(road);
         
-        const int maxActive = 15;
         int activeCount = activeVehicles.size();
         
-        while (!queue.isEmpty() && activeCount < maxActive) {
+        while (!queue.isEmpty() && activeCount < maxActivePerRoad) {
             Vehicle v = queue.dequeue();
+            metrics.at(road, v.getLaneNumber()).queueTime.record(simTime - v.getEntryTime());
+            LaneIndex& laneOrder = getLaneOrder(road, v.getLaneNumber());
+            int leader = laneOrder.back();
             
-            // For lane 2, count only lane 2 vehicles waiting at stop line for proper queue position
+            // For lane 2, queue up one slot behind the car ahead in the lane
             int queuePosition = 0;
-            if (v.getLaneNumber() == 2) {
-                for (const auto& av : activeVehicles) {
-                    if (av.vehicle.getLaneNumber() == 2 && av.vehicle.getAtStop()) {
-                        queuePosition++;
-                    }
-                }
+            if (v.getLaneNumber() == 2 && leader >= 0) {
+                queuePosition = activeVehicles[leader].queueSlot + 1;
             }
             
             // Initialize vehicle far off-screen
             initializeVehiclePosition(v, road, queuePosition);
+            if (leader >= 0) {
+                keepSpawnGap(v, road, leader);
+            }
             
             // Set target to move toward stop line
             setVehicleWaitingPosition(v, road, queuePosition);
             
-            AnimatedVehicle av(v);
-            activeVehicles.push_back(av);
+            int index = activeVehicles.size();
+            activeVehicles.emplace_back(std::move(v));
+            AnimatedVehicle& av = activeVehicles.back();
+            av.queueSlot = queuePosition;
+            av.laneSequence = laneOrder.push(index);
+            kinematics.push(av.vehicle);
+            if (kinematics.held[index]) {
+                markStopped(road, index);
+            }
             activeCount++;
         }
     }
@@ -190,29 +280,54 @@ void TrafficManager::updateVehiclePositions(float deltaTime)
 
     for (char road : roads) {
         std::vector<AnimatedVehicle>& vehicles = getActiveVehicles(road);
-
-        for (auto& av : vehicles) {
-            // If waiting at stop line (lane 2), don't move
-            if (av.vehicle.getAtStop() && !trafficLight.isGreen(road)) {
-                continue;
+        KinematicsArrays& kinematics = getKinematics(road);
+
+        // Vehicles waiting at the stop line (lane 2) only move on green.
+        // When the road turns red every lane-2 car on the approach is held
+        // where it is.
+        bool green = trafficLight.isGreen(road);
+        if (kinematics.setStopReleased(green) && !green) {
+            const LaneIndex& waiting = getLaneOrder(road, 2);
+            for (int slot = 0; slot < waiting.slotCount(); slot++) {
+                int index = waiting.slotAt(slot);
+                if (index >= 0) {
+                    markStopped(road, index);
+                }
             }
-            
-            av.vehicle.updatePosition(deltaTime);
+        }
 
-            if (av.vehicle.hasReachedTarget()) {
+        // Positions follow from the clock; only arrivals need handling
+        kinematics.advance(deltaTime);
+        kinematics.takeArrivals(arrivedIndices);
+
+        for (int i : arrivedIndices) {
+            AnimatedVehicle& av = vehicles[i];
+            if (av.vehicle.getTurnStage() == 0) {
                 // If reached stop line and this is a free-flow lane (1 or 3), proceed through
-                if (isFreeFlowLane(av.vehicle.getLaneNumber()) && av.vehicle.getTurnStage() == 0) {
-                    setVehicleMovingThroughIntersection(av.vehicle, road);
+                if (isFreeFlowLane(av.vehicle.getLaneNumber())) {
+                    setVehicleMovingThroughIntersection(road, i);
                 }
                 // If reached stop line and this is lane 2, wait for green light (marked as atStop)
                 // When light turns green, processCycle will release it
-                else if (av.vehicle.getTurnStage() == 1) {
-                    // Completing the turn through intersection
-                    setVehicleMovingThroughIntersection(av.vehicle, road);
-                }
                 else {
-                    av.isActive = false;
-                    av.hasPassedIntersection = true;
+                    markStopped(road, i);
+                }
+            }
+            else if (av.vehicle.getTurnStage() == 1) {
+                // Completing the turn through intersection
+                setVehicleMovingThroughIntersection(road, i);
+            }
+            else {
+                // Reached the exit point, leave the world
+                av.isActive = false;
+                av.hasPassedIntersection = true;
+                retiredSinceCleanup++;
+                LaneMetrics& laneMetrics = metrics.at(road, av.vehicle.getLaneNumber());
+                laneMetrics.exited++;
+                laneMetrics.systemTime.record(simTime - av.vehicle.getEntryTime());
+                if (collectExits) {
+                    exitedVehicles.push_back(ExitedVehicle(
+                        av.vehicle, getExitRoad(road, av.vehicle.getLaneNumber())));
                 }
             }
         }
@@ -221,16 +336,42 @@ void TrafficManager::updateVehiclePositions(float deltaTime)
 
 
 void TrafficManager::cleanupInactiveVehicles() {
+    // Nothing retired since the last pass, skip walking every vehicle
+    if (retiredSinceCleanup == 0) {
+        return;
+    }
+    retiredSinceCleanup = 0;
+    
     char roads[] = {'A', 'B', 'C', 'D'};
     
     for (char road : roads) {
         std::vector<AnimatedVehicle>& vehicles = getActiveVehicles(road);
+        KinematicsArrays& kinematics = getKinematics(road);
+        
+        // Compact both containers in one pass so indices stay paired
+        int count = vehicles.size();
+        int kept = 0;
+        compactionMap.resize(count);
+        for (int i = 0; i < count; i++) {
+            compactionMap[i] = kept;
+            if (!vehicles[i].isActive) {
+                continue;
+            }
+            if (kept != i) {
+                vehicles[kept] = std::move(vehicles[i]);
+                kinematics.moveElement(i, kept);
+            }
+            kept++;
+        }
         
-        vehicles.erase(
-            std::remove_if(vehicles.begin(), vehicles.end(),
-                [](const AnimatedVehicle& av) { return !av.isActive; }),
-            vehicles.end()
-        );
+        if (kept != count) {
+            vehicles.erase(vehicles.begin() + kept, vehicles.end());
+            kinematics.resize(kept);
+            // Retired vehicles have left their lane already, only survivors move
+            for (int lane = 1; lane <= 3; lane++) {
+                getLaneOrder(road, lane).remap(compactionMap);
+            }
+        }
     }
 }
 
@@ -264,12 +405,12 @@ void TrafficManager::checkProiorityMode() {
     
     if (!trafficLight.isPriorityMode() && laneASize > 10) {
         trafficLight.activatePriorityMode();
-        std::cout << "\n PRIORITY MODE ACTIVATED - Road A has " 
+        if (verbose) std::cout << "\n PRIORITY MODE ACTIVATED - Road A has " 
                   << laneASize << " vehicles!\n" << std::endl;
     }
     else if (trafficLight.isPriorityMode() && laneASize < 5) {
         trafficLight.deactivatePriorityMode();
-        std::cout << "\nPriority mode deactivated - Road A cleared\n" << std::endl;
+        if (verbose) std::cout << "\nPriority mode deactivated - Road A cleared\n" << std::endl;
     }
 }
 
@@ -277,73 +418,326 @@ void TrafficManager::processCycle() {
     checkProiorityMode();
     
     char currentRoad = trafficLight.getCurrentLane();
-    std::vector<AnimatedVehicle>& currentVehicles = getActiveVehicles(currentRoad);
     
-    std::cout << "\n Traffic Light Road " << currentRoad << " is GREEN" << std::endl;
+    if (verbose) {
+        std::cout << "\n Traffic Light Road " << currentRoad << " is GREEN" << std::endl;
+    }
     
-    // Count waiting vehicles in lane 2 (straight only)
-    int waitingCount = 0;
-    AnimatedVehicle* firstWaitingCar = nullptr;
+    // Waiting vehicles in lane 2 (straight only), head of the lane first
+    int waitingCount = getLaneOrder(currentRoad, 2).size();
     
-    for (auto& av : currentVehicles) {
-        if (!av.hasPassedIntersection && av.vehicle.getLaneNumber() == 2 && av.vehicle.getAtStop()) {
-            waitingCount++;
-            if (firstWaitingCar == nullptr) {
-                firstWaitingCar = &av;
-            }
+    if (dischargeMode == DISCHARGE_PLATOON) {
+        // The platoon already left during the green (updateSignals)
+        if (verbose) std::cout << "   Discharged " << phaseReleases << " vehicle(s) from Road "
+                  << currentRoad << " (Remaining: " << waitingCount << " waiting)" << std::endl;
+    }
+    else if (waitingCount == 0) {
+        if (verbose) std::cout << "   No vehicles waiting at light on Road " << currentRoad << std::endl;
+    }
+    // Release only ONE car per cycle (realistic traffic management)
+    else if (releaseWaitingHead(currentRoad, false)) {
+        if (verbose) std::cout << "   Released 1 vehicle from Road " << currentRoad 
+                  << " (Remaining: " << (waitingCount - 1) << " waiting)" << std::endl;
+    }
+    
+    trafficLight.switchToNextLane();
+    startGreen();
+}
+
+// Sends the first lane-2 car of a road through the intersection. With
+// onlyAtStopLine a car still driving up to its place in the queue is left
+// alone, so platoons leave at the rate cars reach the line.
+bool TrafficManager::releaseWaitingHead(char road, bool onlyAtStopLine) {
+    int head = getLaneOrder(road, 2).front();
+    if (head < 0) {
+        return false;
+    }
+    
+    KinematicsArrays& kinematics = getKinematics(road);
+    if (onlyAtStopLine && kinematics.moving[head]) {
+        return false;
+    }
+    
+    setVehicleMovingThroughIntersection(road, head);
+    kinematics.releaseStop(head);
+    getActiveVehicles(road)[head].hasPassedIntersection = true;
+    totalVehiclesProcessed++;
+    dischargeStats[road - 'A'].released++;
+    
+    moveUpWaitingQueue(road);
+    return true;
+}
+
+// The head just left: everyone still waiting in lane 2 drives up one place
+void TrafficManager::moveUpWaitingQueue(char road) {
+    const LaneIndex& waiting = getLaneOrder(road, 2);
+    std::vector<AnimatedVehicle>& vehicles = getActiveVehicles(road);
+    KinematicsArrays& kinematics = getKinematics(road);
+    
+    for (int i = 0; i < waiting.slotCount(); i++) {
+        int index = waiting.slotAt(i);
+        if (index < 0 || vehicles[index].queueSlot == 0) {
+            continue;
         }
+        
+        AnimatedVehicle& av = vehicles[index];
+        av.queueSlot--;
+        float targetX, targetY;
+        waitingTarget(road, 2, av.queueSlot, targetX, targetY);
+        kinematics.setTarget(index, targetX, targetY, 80.0f);
     }
+}
+
+// Platoon discharge on the green road: the head leaves after the start-up
+// lost time, each following car one saturation headway after the last
+void TrafficManager::dischargePlatoon(char road) {
+    bool due = dischargeStarted
+        ? sinceDischarge >= dischargeTiming.saturationHeadway
+        : greenElapsed >= dischargeTiming.startupLostTime;
     
-    if (waitingCount == 0) {
-        std::cout << "   No vehicles waiting at light on Road " << currentRoad << std::endl;
+    if (due && releaseWaitingHead(road, true)) {
+        sinceDischarge = 0.0f;
+        phaseReleases++;
+        dischargeStarted = true;
     }
-    else {
-        // Release only ONE car per cycle (realistic traffic management)
-        if (firstWaitingCar != nullptr) {
-            setVehicleMovingThroughIntersection(firstWaitingCar->vehicle, currentRoad);
-            firstWaitingCar->vehicle.setAtStop(false);
-            firstWaitingCar->hasPassedIntersection = true;
-            totalVehiclesProcessed++;
-            
-            std::cout << "   Released 1 vehicle from Road " << currentRoad 
-                      << " (Remaining: " << (waitingCount - 1) << " waiting)" << std::endl;
+}
+
+void TrafficManager::startGreen() {
+    greenElapsed = 0.0f;
+    sinceDischarge = 0.0f;
+    phaseReleases = 0;
+    dischargeStarted = false;
+}
+
+void TrafficManager::setSignalControl(SignalControl mode, const ActuatedTiming& timing) {
+    signalControl = mode;
+    actuatedTiming = timing;
+    startGreen();
+}
+
+bool TrafficManager::isActuated() const {
+    return signalControl == SIGNAL_ACTUATED;
+}
+
+void TrafficManager::setDischarge(DischargeMode mode, const DischargeTiming& timing) {
+    dischargeMode = mode;
+    dischargeTiming = timing;
+    startGreen();
+}
+
+const DischargeStats& TrafficManager::getDischargeStats(char road) const {
+    int index = (road >= 'A' && road <= 'D') ? road - 'A' : 0;
+    return dischargeStats[index];
+}
+
+// Next road in A -> B -> C -> D order with lane-2 cars on its approach.
+// Priority mode always goes back to A; with nobody waiting anywhere else the
+// current road keeps the green.
+char TrafficManager::nextActuatedRoad() const {
+    char current = trafficLight.getCurrentLane();
+    if (trafficLight.isPriorityMode()) {
+        return 'A';
+    }
+    
+    const char roads[] = {'A', 'B', 'C', 'D'};
+    int currentIndex = current - 'A';
+    for (int offset = 1; offset <= 4; offset++) {
+        char road = roads[(currentIndex + offset) % 4];
+        if (getWaitingCount(road) > 0) {
+            return road;
         }
     }
+    return current;
+}
+
+bool TrafficManager::updateSignals(float deltaTime) {
+    char currentRoad = trafficLight.getCurrentLane();
+    greenElapsed += deltaTime;
+    sinceDischarge += deltaTime;
     
-    trafficLight.switchToNextLane();
+    DischargeStats& stats = dischargeStats[currentRoad - 'A'];
+    stats.greenSeconds += deltaTime;
+    if (getWaitingCount(currentRoad) > 0) {
+        stats.queuedGreenSeconds += deltaTime;
+    }
+    
+    if (signalControl == SIGNAL_ACTUATED || dischargeMode == DISCHARGE_PLATOON) {
+        dischargePlatoon(currentRoad);
+    }
+    
+    if (signalControl != SIGNAL_ACTUATED) {
+        return false;
+    }
+    
+    bool maxedOut = greenElapsed >= actuatedTiming.maxGreen;
+    bool gappedOut = greenElapsed >= actuatedTiming.minGreen
+                  && sinceDischarge >= actuatedTiming.passageTime;
+    if (!maxedOut && !gappedOut) {
+        return false;
+    }
+    
+    checkProiorityMode();
+    char nextRoad = nextActuatedRoad();
+    
+    if (verbose && (phaseReleases > 0 || nextRoad != currentRoad)) {
+        std::cout << "Road " << currentRoad << " green for " << greenElapsed << " s, released "
+                  << phaseReleases << " vehicle(s), " << (maxedOut ? "max-out" : "gap-out")
+                  << " -> Road " << nextRoad << " GREEN" << std::endl;
+    }
+    
+    if (nextRoad == currentRoad) {
+        // Same road again: a new phase for the timers, but a platoon still
+        // moving (max-out) does not pay the start-up loss a second time
+        greenElapsed = 0.0f;
+        phaseReleases = 0;
+        dischargeStarted = dischargeStarted && maxedOut;
+        return false;
+    }
+    trafficLight.switchTo(nextRoad);
+    startGreen();
+    return true;
 }
 
-void TrafficManager::loadVehiclesFromFiles() {
-    std::vector<Vehicle> newA, newB, newC, newD;
-    FileReader::readAllLaneFiles(newA, newB, newC, newD);
+// Every segment knows its arrival time. The per-road bound may be early
+// after a hold or a new target, which costs one step that finds nothing.
+double TrafficManager::secondsUntilNextReach() const {
+    double next = std::numeric_limits<double>::infinity();
+    const char roads[] = {'A', 'B', 'C', 'D'};
+    
+    for (char road : roads) {
+        const KinematicsArrays& k = getKinematics(road);
+        next = std::min(next, std::max(0.0, k.nextArrival - k.clock));
+    }
+    return next;
+}
+
+// The same thresholds updateSignals() tests, as time left until they pass
+double TrafficManager::secondsUntilSignalDue() const {
+    double next = std::numeric_limits<double>::infinity();
+    char currentRoad = trafficLight.getCurrentLane();
     
+    bool platoon = signalControl == SIGNAL_ACTUATED || dischargeMode == DISCHARGE_PLATOON;
+    if (platoon && getWaitingCount(currentRoad) > 0) {
+        // Not yet due; once due the release waits for the head to reach the
+        // line, which secondsUntilNextReach() covers
+        float wait = dischargeStarted
+            ? dischargeTiming.saturationHeadway - sinceDischarge
+            : dischargeTiming.startupLostTime - greenElapsed;
+        if (wait > 0.0f) {
+            next = wait;
+        }
+    }
+    
+    if (signalControl == SIGNAL_ACTUATED) {
+        float maxOut = actuatedTiming.maxGreen - greenElapsed;
+        float gapOut = std::max(actuatedTiming.minGreen - greenElapsed,
+                                actuatedTiming.passageTime - sinceDischarge);
+        if (maxOut > 0.0f && maxOut < next) {
+            next = maxOut;
+        }
+        if (gapOut > 0.0f && gapOut < next) {
+            next = gapOut;
+        }
+    }
+    return next;
+}
+
+bool TrafficManager::canSpawnQueued() const {
+    const char roads[] = {'A', 'B', 'C', 'D'};
+    for (char road : roads) {
+        Queue<Vehicle>& queue = const_cast<TrafficManager*>(this)->getLaneQueue(road);
+        if (!queue.isEmpty()
+            && static_cast<int>(getActiveVehicles(road).size()) < maxActivePerRoad) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TrafficManager::recordArrivals(const std::vector<Vehicle>& arrivals) {
+    for (const auto& v : arrivals) {
+        traceRecorder->record(v, simTime);
+    }
+}
+
+void TrafficManager::stampArrivals(std::vector<Vehicle>& arrivals) {
+    for (auto& v : arrivals) {
+        v.setEntryTime(simTime);
+        metrics.at(v.getRoadName(), v.getLaneNumber()).arrived++;
+    }
+}
+
+// Start of the stop-line delay of a lane-2 car, the first time it stands
+// still in the queue
+void TrafficManager::markStopped(char road, int index) {
+    AnimatedVehicle& av = getActiveVehicles(road)[index];
+    if (av.stopLineTime < 0.0) {
+        av.stopLineTime = simTime;
+    }
+}
+
+int TrafficManager::enqueueArrivals() {
     int loadedCount = 0;
     
-    for (const auto& v : newA) {
-        laneA.enqueue(v);
+    if (traceRecorder != nullptr) {
+        recordArrivals(arrivalsA);
+        recordArrivals(arrivalsB);
+        recordArrivals(arrivalsC);
+        recordArrivals(arrivalsD);
+    }
+    stampArrivals(arrivalsA);
+    stampArrivals(arrivalsB);
+    stampArrivals(arrivalsC);
+    stampArrivals(arrivalsD);
+    
+    for (auto& v : arrivalsA) {
+        laneA.enqueue(std::move(v));
         loadedCount++;
     }
     
-    for (const auto& v : newB) {
-        laneB.enqueue(v);
+    for (auto& v : arrivalsB) {
+        laneB.enqueue(std::move(v));
         loadedCount++;
     }
     
-    for (const auto& v : newC) {
-        laneC.enqueue(v);
+    for (auto& v : arrivalsC) {
+        laneC.enqueue(std::move(v));
         loadedCount++;
     }
     
-    for (const auto& v : newD) {
-        laneD.enqueue(v);
+    for (auto& v : arrivalsD) {
+        laneD.enqueue(std::move(v));
         loadedCount++;
     }
     
-    if (loadedCount > 0) {
+    arrivalsA.clear();
+    arrivalsB.clear();
+    arrivalsC.clear();
+    arrivalsD.clear();
+    
+    return loadedCount;
+}
+
+void TrafficManager::loadVehiclesFromFiles() {
+    FileReader::readAllLaneFiles(arrivalsA, arrivalsB, arrivalsC, arrivalsD, laneFileFormat);
+    
+    int loadedCount = enqueueArrivals();
+    
+    if (verbose && loadedCount > 0) {
         std::cout << "Loaded " << loadedCount << " new vehicle(s) from files" << std::endl;
     }
 }
 
+void TrafficManager::loadVehiclesFrom(VehicleSource& source) {
+    source.poll(arrivalsA, arrivalsB, arrivalsC, arrivalsD);
+    
+    int loadedCount = enqueueArrivals();
+    
+    if (verbose && loadedCount > 0) {
+        std::cout << "Received " << loadedCount << " new vehicle(s)" << std::endl;
+    }
+}
+
 void TrafficManager::display() const {
     std::cout << "Road A (Priority): " << laneA.getSize() 
               << " queued + " << activeVehiclesA.size() << " active" << std::endl;
@@ -373,36 +767,111 @@ int TrafficManager::getTotalProcessed() const {
     return totalVehiclesProcessed;
 }
 
-void TrafficManager::renderToSDL(SDLRenderer& renderer) const {
-    renderer.clear();
-    renderer.drawRoad();
-    
-    char currentRoad = trafficLight.getCurrentLane();
-    bool isPriority = trafficLight.isPriorityMode();
-    renderer.drawTrafficLight(currentRoad, isPriority);
+int TrafficManager::getWaitingCount(char road) const {
+    return getLaneOrder(road, 2).size();
+}
+
+int TrafficManager::getLeader(char road, int index) const {
+    const AnimatedVehicle& av = getActiveVehicles(road)[index];
+    if (av.vehicle.getTurnStage() != 0) {
+        return -1;
+    }
+    return getLaneOrder(road, av.vehicle.getLaneNumber()).leaderOf(av.laneSequence);
+}
+
+void TrafficManager::setLaneFileFormat(LaneFileFormat format) {
+    laneFileFormat = format;
+}
+
+void TrafficManager::setTraceRecorder(TraceRecorder* recorder) {
+    traceRecorder = recorder;
+}
+
+void TrafficManager::setSimTime(double simSeconds) {
+    simTime = simSeconds;
+}
+
+double TrafficManager::getSimTime() const {
+    return simTime;
+}
+
+const TrafficMetrics& TrafficManager::getMetrics() const {
+    return metrics;
+}
+
+void TrafficManager::setVerbose(bool enabled) {
+    verbose = enabled;
+}
+
+void TrafficManager::setMaxActivePerRoad(int maxActive) {
+    maxActivePerRoad = maxActive;
+}
+
+void TrafficManager::setCollectExits(bool enabled) {
+    collectExits = enabled;
+    if (!enabled) {
+        exitedVehicles.clear();
+    }
+}
+
+void TrafficManager::takeExitedVehicles(std::vector<ExitedVehicle>& out) {
+    out.clear();
+    out.swap(exitedVehicles);
+}
+
+// Which road a vehicle enters on at the next junction, following the exit
+// targets in setVehicleMovingThroughIntersection
+char TrafficManager::getExitRoad(char road, int lane) {
+    switch (road) {
+        case 'A': return (lane == 1) ? 'D' : (lane == 2) ? 'A' : 'B';
+        case 'B': return (lane == 1) ? 'A' : (lane == 2) ? 'B' : 'C';
+        case 'C': return (lane == 1) ? 'B' : (lane == 2) ? 'C' : 'D';
+        case 'D': return (lane == 1) ? 'C' : (lane == 2) ? 'D' : 'A';
+        default: return road;
+    }
+}
+
+void TrafficManager::captureRenderState(RenderState& state) const {
+    state.vehicles.clear();
+    state.vehicles.reserve(getActiveCount());
     
     char roads[] = {'A', 'B', 'C', 'D'};
     for (char road : roads) {
         const std::vector<AnimatedVehicle>& vehicles = getActiveVehicles(road);
-        for (const auto& av : vehicles) {
-            renderer.drawAnimatedVehicle(
-                av.vehicle.getX(), 
-                av.vehicle.getY(), 
-                road,
-                av.vehicle.getLaneNumber()
-            );
+        const KinematicsArrays& kinematics = getKinematics(road);
+        evaluatePositions(kinematics);
+        for (size_t i = 0; i < vehicles.size(); i++) {
+            RenderVehicle v;
+            v.x = kinematics.x[i];
+            v.y = kinematics.y[i];
+            v.road = road;
+            v.lane = vehicles[i].vehicle.getLaneNumber();
+            state.vehicles.push_back(v);
         }
     }
     
-    renderer.drawStats(0, totalVehiclesProcessed, laneA.getSize());
-    renderer.present();
+    state.greenRoad = trafficLight.getCurrentLane();
+    state.priorityMode = trafficLight.isPriorityMode();
+    state.totalProcessed = totalVehiclesProcessed;
+    state.queuedA = laneA.getSize();
+    state.simTime = simTime;
 }
-void TrafficManager::setVehicleMovingThroughIntersection(Vehicle& vehicle, char road)
+
+int TrafficManager::getActiveCount() const {
+    return activeVehiclesA.size() + activeVehiclesB.size()
+         + activeVehiclesC.size() + activeVehiclesD.size();
+}
+
+void TrafficManager::setVehicleMovingThroughIntersection(char road, int index)
 {
     const int centerX = 450;
     const int centerY = 350;
     const int laneWidth = 60;
 
+    AnimatedVehicle& av = getActiveVehicles(road)[index];
+    Vehicle& vehicle = av.vehicle;
+    KinematicsArrays& kinematics = getKinematics(road);
+
     int lane = vehicle.getLaneNumber();
     int laneOffset = (lane - 1) * laneWidth + laneWidth/2;
 
@@ -421,47 +890,60 @@ void TrafficManager::setVehicleMovingThroughIntersection(Vehicle& vehicle, char
             intersectionY = centerY;
         }
         
-        vehicle.setTarget(intersectionX, intersectionY);
-        vehicle.setMoving(true);
-        vehicle.setSpeed(120.0f);
+        kinematics.setTarget(index, intersectionX, intersectionY, 120.0f);
         vehicle.setTurnStage(1);
+        
+        // Leaving the approach, the next car in the lane becomes its head
+        getLaneOrder(road, lane).remove(av.laneSequence);
+        
+        LaneMetrics& laneMetrics = metrics.at(road, lane);
+        laneMetrics.released++;
+        if (!isFreeFlowLane(lane)) {
+            // Released before it ever stood still: no delay
+            double stoppedAt = (av.stopLineTime >= 0.0) ? av.stopLineTime : simTime;
+            laneMetrics.stopDelay.record(simTime - stoppedAt);
+        }
         return;
     }
 
     // STEP 2: Exit based on road + lane (maintain lane separation)
+    float exitX = kinematics.targetX[index];
+    float exitY = kinematics.targetY[index];
+    auto exitTo = [&](float x, float y) { exitX = x; exitY = y; };
+    
     if (road == 'A') { // vehicles entering from LEFT, going RIGHT
         // Lane 1 (top): LEFT turn → exit UP in top lane
-        if (lane == 1) vehicle.setTarget(centerX - 90, -50);
+        if (lane == 1) exitTo(centerX - 90, -50);
         // Lane 2 (middle): STRAIGHT → exit RIGHT in middle lane
-        if (lane == 2) vehicle.setTarget(950, centerY);
+        if (lane == 2) exitTo(950, centerY);
         // Lane 3 (bottom): RIGHT turn → exit DOWN in bottom lane
-        if (lane == 3) vehicle.setTarget(centerX + 90, 750);
+        if (lane == 3) exitTo(centerX + 90, 750);
     }
     else if (road == 'B') { // vehicles entering from TOP, going DOWN
         // Lane 1 (left): LEFT turn → exit RIGHT in right lane
-        if (lane == 1) vehicle.setTarget(950, centerY - 90);
+        if (lane == 1) exitTo(950, centerY - 90);
         // Lane 2 (middle): STRAIGHT → exit DOWN in middle lane
-        if (lane == 2) vehicle.setTarget(centerX, 750);
+        if (lane == 2) exitTo(centerX, 750);
         // Lane 3 (right): RIGHT turn → exit LEFT in left lane
-        if (lane == 3) vehicle.setTarget(-50, centerY + 90);
+        if (lane == 3) exitTo(-50, centerY + 90);
     }
     else if (road == 'C') { // vehicles entering from RIGHT, going LEFT
         // Lane 1 (bottom): LEFT turn → exit DOWN in bottom lane
-        if (lane == 1) vehicle.setTarget(centerX + 90, 750);
+        if (lane == 1) exitTo(centerX + 90, 750);
         // Lane 2 (middle): STRAIGHT → exit LEFT in middle lane
-        if (lane == 2) vehicle.setTarget(-50, centerY);
+        if (lane == 2) exitTo(-50, centerY);
         // Lane 3 (top): RIGHT turn → exit UP in top lane
-        if (lane == 3) vehicle.setTarget(centerX - 90, -50);
+        if (lane == 3) exitTo(centerX - 90, -50);
     }
     else if (road == 'D') { // vehicles entering from BOTTOM, going UP
         // Lane 1 (right): LEFT turn → exit LEFT in left lane
-        if (lane == 1) vehicle.setTarget(-50, centerY + 90);
+        if (lane == 1) exitTo(-50, centerY + 90);
         // Lane 2 (middle): STRAIGHT → exit UP in middle lane
-        if (lane == 2) vehicle.setTarget(centerX, -50);
+        if (lane == 2) exitTo(centerX, -50);
         // Lane 3 (left): RIGHT turn → exit RIGHT in right lane
-        if (lane == 3) vehicle.setTarget(950, centerY - 90);
+        if (lane == 3) exitTo(950, centerY - 90);
     }
 
-    vehicle.setMoving(true);
-    vehicle.setSpeed(120.0f);
+    kinematics.setTarget(index, exitX, exitY, 120.0f);
+    vehicle.setTurnStage(2);
 }
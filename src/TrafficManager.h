@@ -5,17 +5,123 @@
 #include "Vehicle.h"
 #include "TrafficLight.h"
 #include "FileReader.h"
+#include "VehicleKinematics.h"
+#include "LaneIndex.h"
+#include "VehicleFeed.h"
+#include "VehicleTrace.h"
+#include "TrafficMetrics.h"
 #include <vector>
+#include <string>
+#include <utility>
 
 class SDLRenderer;
 
+// Identity and lifecycle of an active vehicle. Its position, target, speed
+// and stop flag live in the road's KinematicsArrays at the same index; the
+// copies inside `vehicle` are only meaningful until it is spawned.
 struct AnimatedVehicle {
     Vehicle vehicle;
     bool isActive;
     bool hasPassedIntersection;
+    long long laneSequence;   // position key in the road's LaneIndex for its lane
+    int queueSlot;            // stop-line slot (lane 2), 0 = first at the line
+    double stopLineTime;      // simulated seconds it first stood in the lane-2 queue, -1 before
     
     AnimatedVehicle(const Vehicle& v) 
-        : vehicle(v), isActive(true), hasPassedIntersection(false) {}
+        : vehicle(v), isActive(true), hasPassedIntersection(false),
+          laneSequence(0), queueSlot(0), stopLineTime(-1.0) {}
+    AnimatedVehicle(Vehicle&& v) 
+        : vehicle(std::move(v)), isActive(true), hasPassedIntersection(false),
+          laneSequence(0), queueSlot(0), stopLineTime(-1.0) {}
+};
+
+// A vehicle that drove out of the intersection, with the road it would enter
+// on at the neighbouring junction ('A' = heading right, 'B' = heading down,
+// 'C' = heading left, 'D' = heading up)
+struct ExitedVehicle {
+    Vehicle vehicle;
+    char nextRoad;
+    
+    ExitedVehicle(const Vehicle& v, char next) : vehicle(v), nextRoad(next) {}
+};
+
+// What drawing one moment of the simulation takes, copied out of the
+// manager so another thread can draw it while the simulation moves on
+struct RenderVehicle {
+    float x, y;
+    char road;
+    int lane;
+};
+
+struct RenderState {
+    std::vector<RenderVehicle> vehicles;
+    char greenRoad;
+    bool priorityMode;
+    int totalProcessed;
+    int queuedA;
+    double simTime;
+    long long step;       // simulation step that produced it (SimulationThread)
+    float stepMicros;     // wall time that step took
+    // Its phases, when the clock times them (SimulationClock::setPhaseTiming)
+    float loadMicros;
+    float spawnMicros;
+    float updateMicros;
+    float signalsMicros;
+    float cleanupMicros;
+    
+    RenderState()
+        : greenRoad('A'), priorityMode(false), totalProcessed(0), queuedA(0),
+          simTime(0.0), step(0), stepMicros(0.0f), loadMicros(0.0f), spawnMicros(0.0f),
+          updateMicros(0.0f), signalsMicros(0.0f), cleanupMicros(0.0f) {}
+};
+
+// How the lights change. FIXED is the original controller: whoever drives
+// the manager calls processCycle() on a timer, which moves the green to the
+// next road. ACTUATED runs off updateSignals() every step instead: the green
+// road discharges its stop line queue as a platoon and keeps the green while
+// cars are still leaving, ending on a gap or at the maximum green, and the
+// green then skips roads with nobody waiting.
+enum SignalControl {
+    SIGNAL_FIXED,
+    SIGNAL_ACTUATED
+};
+
+struct ActuatedTiming {
+    float minGreen;      // seconds of green before the phase may gap out
+    float maxGreen;      // seconds after which the phase ends regardless
+    float passageTime;   // gap: the phase ends once nobody left for this long
+    
+    ActuatedTiming() : minGreen(5.0f), maxGreen(30.0f), passageTime(3.0f) {}
+};
+
+// How waiting lane-2 cars leave the stop line. SINGLE is the original
+// behaviour under fixed control: each processCycle() releases the head of
+// the green road's queue and nobody else. PLATOON discharges the whole queue
+// while the road has the green: the head leaves once the start-up lost time
+// has passed, every following car one saturation headway after the car
+// ahead. Actuated control always discharges as a platoon. Either way the
+// cars behind move up a place whenever the head leaves.
+enum DischargeMode {
+    DISCHARGE_SINGLE,
+    DISCHARGE_PLATOON
+};
+
+struct DischargeTiming {
+    float startupLostTime;     // seconds of green before the first car leaves
+    float saturationHeadway;   // seconds between following cars
+    
+    DischargeTiming() : startupLostTime(2.0f), saturationHeadway(2.0f) {}
+};
+
+// Lane-2 cars released at the stop line of one road and the green they had,
+// for capacity figures. queuedGreenSeconds only counts green with somebody
+// waiting, so released / queuedGreenSeconds is the saturation flow.
+struct DischargeStats {
+    long long released;
+    double greenSeconds;
+    double queuedGreenSeconds;
+    
+    DischargeStats() : released(0), greenSeconds(0.0), queuedGreenSeconds(0.0) {}
 };
 
 class TrafficManager {
@@ -30,22 +136,76 @@ private:
     std::vector<AnimatedVehicle> activeVehiclesC;
     std::vector<AnimatedVehicle> activeVehiclesD;
     
+    KinematicsArrays kinematicsA;
+    KinematicsArrays kinematicsB;
+    KinematicsArrays kinematicsC;
+    KinematicsArrays kinematicsD;
+    
+    // Per-lane order of the vehicles still approaching the stop line
+    LaneIndex laneOrderA[3];
+    LaneIndex laneOrderB[3];
+    LaneIndex laneOrderC[3];
+    LaneIndex laneOrderD[3];
+    std::vector<int> compactionMap;
+    std::vector<int> arrivedIndices;
+    
     TrafficLight trafficLight;
+    SignalControl signalControl;
+    ActuatedTiming actuatedTiming;
+    DischargeMode dischargeMode;
+    DischargeTiming dischargeTiming;
+    float greenElapsed;       // time the current road has had the green
+    float sinceDischarge;     // time since a car last left its stop line
+    int phaseReleases;
+    bool dischargeStarted;    // the green road's platoon is already moving
+    DischargeStats dischargeStats[4];
     int totalVehiclesProcessed;
+    bool verbose;
+    int maxActivePerRoad;
+    int retiredSinceCleanup;
+    bool collectExits;
+    LaneFileFormat laneFileFormat;
+    std::vector<ExitedVehicle> exitedVehicles;
+    TraceRecorder* traceRecorder;
+    double simTime;
+    TrafficMetrics metrics;
+    
+    // Scratch batches reused by every load so polling does not allocate
+    std::vector<Vehicle> arrivalsA;
+    std::vector<Vehicle> arrivalsB;
+    std::vector<Vehicle> arrivalsC;
+    std::vector<Vehicle> arrivalsD;
     
     Queue<Vehicle>& getLaneQueue(char road);
     std::vector<AnimatedVehicle>& getActiveVehicles(char road);
     const std::vector<AnimatedVehicle>& getActiveVehicles(char road) const;
+    KinematicsArrays& getKinematics(char road);
+    const KinematicsArrays& getKinematics(char road) const;
+    LaneIndex& getLaneOrder(char road, int lane);
+    const LaneIndex& getLaneOrder(char road, int lane) const;
+    
+    static float travelProgress(char road, float x, float y);
+    void keepSpawnGap(Vehicle& vehicle, char road, int leaderIndex);
     
     void initializeVehiclePosition(Vehicle& vehicle, char road, int queuePosition);
     void setVehicleWaitingPosition(Vehicle& vehicle, char road, int queuePosition);
-    void setVehicleMovingThroughIntersection(Vehicle& vehicle, char road);
+    void setVehicleMovingThroughIntersection(char road, int index);
     
     int calculateAverageVehicles() const;
     void checkProiorityMode();
+    static void waitingTarget(char road, int lane, int queuePosition, float& targetX, float& targetY);
+    bool releaseWaitingHead(char road, bool onlyAtStopLine);
+    void moveUpWaitingQueue(char road);
+    void dischargePlatoon(char road);
+    void startGreen();
+    char nextActuatedRoad() const;
     
    
     bool isFreeFlowLane(int lane) const;
+    void recordArrivals(const std::vector<Vehicle>& arrivals);
+    void stampArrivals(std::vector<Vehicle>& arrivals);
+    void markStopped(char road, int index);
+    int enqueueArrivals();
     
 public:
     TrafficManager();
@@ -56,14 +216,88 @@ public:
     void cleanupInactiveVehicles();
     
     void processCycle();
+    
+    // Fixed (default) or actuated control, see SignalControl
+    void setSignalControl(SignalControl mode, const ActuatedTiming& timing = ActuatedTiming());
+    bool isActuated() const;
+    // Single-car (default) or platoon discharge, see DischargeMode
+    void setDischarge(DischargeMode mode, const DischargeTiming& timing = DischargeTiming());
+    // Called every step: discharges the green road as a platoon where that
+    // applies and runs actuated control. Returns true when actuated control
+    // moved the green to another road.
+    bool updateSignals(float deltaTime);
+    const DischargeStats& getDischargeStats(char road) const;
+    
+    // For EventClock: simulated seconds until something would happen by
+    // itself if the manager were advanced, infinity when nothing will.
+    // secondsUntilNextReach() is the first moving vehicle reaching its
+    // target (stop line, turn point or exit); secondsUntilSignalDue() the
+    // next platoon release or actuated max-out/gap-out threshold.
+    double secondsUntilNextReach() const;
+    double secondsUntilSignalDue() const;
+    // A queued vehicle has room to be spawned on its road
+    bool canSpawnQueued() const;
+    
     void display() const;
     void loadVehiclesFromFiles();
+    void loadVehiclesFrom(VehicleSource& source);
     
     char getCurrentLane() const;
     int getVehiclesToProcess(char road) const;
     int getLaneSize(char road) const;
     int getTotalProcessed() const;
     
+    // Lane-2 vehicles on the approach of a road, waiting for their release
+    int getWaitingCount(char road) const;
+    // Active index of the vehicle directly ahead in the same lane, or -1 if
+    // the vehicle is first in line or already past the stop line
+    int getLeader(char road, int index) const;
+    
+    // Format loadVehiclesFromFiles() expects (text lane_X.txt by default)
+    void setLaneFileFormat(LaneFileFormat format);
+    
+    // Every vehicle taken in by a load is also written to the trace (not
+    // owned), stamped with the simulated time from setSimTime()
+    void setTraceRecorder(TraceRecorder* recorder);
+    
+    // Current simulated time, which SimulationClock sets every step. It
+    // stamps arrivals, stop-line waits, releases and exits for the metrics.
+    void setSimTime(double simSeconds);
+    double getSimTime() const;
+    
+    // Per-(road, lane) flow counters and latency histograms, see
+    // TrafficMetrics. Not part of snapshots: a restored run measures from
+    // the point it was restored, leaving the warm-up out.
+    const TrafficMetrics& getMetrics() const;
+    
+    // Console logging of arrivals and light cycles; headless runs turn it off
+    void setVerbose(bool enabled);
+    
+    // Cap on vehicles animated at once per road (default 15); the rest wait
+    // in the road's queue
+    void setMaxActivePerRoad(int maxActive);
+    int getActiveCount() const;
+    
+    // When enabled, vehicles leaving the intersection are kept for
+    // takeExitedVehicles() so a network can hand them to the next junction
+    void setCollectExits(bool enabled);
+    void takeExitedVehicles(std::vector<ExitedVehicle>& out);
+    static char getExitRoad(char road, int lane);
+    
+    // Compact binary copy of the whole simulation state: queued and active
+    // vehicles with their motion state, lane order, light phase and
+    // counters, so a warmed-up scenario can be saved once and forked.
+    // Settings (verbosity, caps, signal control, file format, trace) are not
+    // part of it. Native byte order; readSnapshot() returns false on
+    // malformed data and leaves the manager untouched.
+    void writeSnapshot(std::vector<char>& out) const;
+    bool readSnapshot(const char* data, size_t size);
+    bool saveSnapshot(const std::string& filename) const;
+    bool loadSnapshot(const std::string& filename);
+    
+    // Fills state from the current simulation, reusing its vector
+    void captureRenderState(RenderState& state) const;
+    static void renderState(const RenderState& state, SDLRenderer& renderer);
     void renderToSDL(SDLRenderer& renderer) const;
 };
 
@@ -0,0 +1,43 @@
+#include "TrafficManager.h"
+#include "SDLRenderer.h"
+
+// Kept apart from TrafficManager.cpp so console and headless builds do not
+// need SDL.
+
+void TrafficManager::renderState(const RenderState& state, SDLRenderer& renderer) {
+    renderer.clear();
+    renderer.drawRoad();
+    renderer.drawTrafficLight(state.greenRoad, state.priorityMode);
+    
+    // Vehicles keep their gaps, so their parts can be drawn colour by colour.
+    // With queue bars on, the ones not drawn (outside the window, or all of
+    // them when zoomed far out) are counted per road and lane instead.
+    bool queueBars = renderer.showsQueueBars();
+    bool barsOnly = queueBars && renderer.isZoomedOut();
+    int hidden[4][3] = {{0}};
+    renderer.beginColorGroups();
+    for (const RenderVehicle& v : state.vehicles) {
+        bool drawn = !barsOnly && renderer.drawAnimatedVehicle(v.x, v.y, v.road, v.lane);
+        if (!drawn && queueBars && v.road >= 'A' && v.road <= 'D' && v.lane >= 1 && v.lane <= 3) {
+            hidden[v.road - 'A'][v.lane - 1]++;
+        }
+    }
+    renderer.endColorGroups();
+    
+    if (queueBars) {
+        for (int road = 0; road < 4; road++) {
+            for (int lane = 1; lane <= 3; lane++) {
+                renderer.drawQueue(static_cast<char>('A' + road), lane, hidden[road][lane - 1]);
+            }
+        }
+    }
+    
+    renderer.drawStats(0, state.totalProcessed, state.queuedA);
+    renderer.present();
+}
+
+void TrafficManager::renderToSDL(SDLRenderer& renderer) const {
+    RenderState state;
+    captureRenderState(state);
+    renderState(state, renderer);
+}
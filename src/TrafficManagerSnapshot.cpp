@@ -0,0 +1,411 @@
+#include "TrafficManager.h"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <cstring>
+#include <cstdint>
+
+// Snapshot layout, all fields in native byte order:
+//
+//   "TMSS", uint16 version, uint16 reserved
+//   int32 totalVehiclesProcessed, int32 retiredSinceCleanup
+//   char light lane, uint8 priority mode
+//   float green elapsed, float since discharge, int32 phase releases
+//   uint8 discharge started, per road A..D: int64 released, double green
+//   seconds, double queued green seconds
+//   double simulated time
+//   per road A..D:
+//     uint32 queued,  queued x vehicle
+//     uint32 active,  active x (vehicle, uint8 flags, int64 laneSequence,
+//                               int32 queueSlot, double stop-line time)
+//     per lane 1..3:  int64 head sequence, uint32 slots, slots x int32
+//   uint32 exited,  exited x (vehicle, char next road)
+//
+// A vehicle is its plate (uint8 length + text, since plate IDs are only
+// valid in the process that interned them), road, uint8 lane, int32 turn
+// stage, entry time (double simulated seconds), x, y, target x/y and speed
+// as floats and a uint8
+// with the moving (1) and at-stop (2) flags. Active vehicles store the
+// motion state of their KinematicsArrays row rather than the stale copy
+// inside the Vehicle.
+
+namespace {
+
+const char SNAPSHOT_MAGIC[4] = {'T', 'M', 'S', 'S'};
+const uint16_t SNAPSHOT_VERSION = 1;
+
+class SnapshotWriter {
+private:
+    std::vector<char>& out;
+
+public:
+    explicit SnapshotWriter(std::vector<char>& buffer) : out(buffer) {}
+
+    template <typename T>
+    void put(T value) {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void putBytes(const char* bytes, size_t length) {
+        out.insert(out.end(), bytes, bytes + length);
+    }
+};
+
+// Every get fails once the data runs out, so callers check ok() at the
+// points where a bad count would otherwise make them allocate or loop
+class SnapshotReader {
+private:
+    const char* position;
+    const char* end;
+    bool valid;
+
+public:
+    SnapshotReader(const char* data, size_t size)
+        : position(data), end(data + size), valid(true) {}
+
+    template <typename T>
+    bool get(T& value) {
+        if (!valid || static_cast<size_t>(end - position) < sizeof(T)) {
+            valid = false;
+            return false;
+        }
+        std::memcpy(&value, position, sizeof(T));
+        position += sizeof(T);
+        return true;
+    }
+
+    bool getBytes(char* bytes, size_t length) {
+        if (!valid || static_cast<size_t>(end - position) < length) {
+            valid = false;
+            return false;
+        }
+        std::memcpy(bytes, position, length);
+        position += length;
+        return true;
+    }
+
+    // A count cannot exceed the bytes left when every item takes at least
+    // minItemSize of them
+    bool getCount(uint32_t& count, size_t minItemSize) {
+        if (!get(count)) return false;
+        if (count > static_cast<size_t>(end - position) / minItemSize) {
+            valid = false;
+        }
+        return valid;
+    }
+
+    void fail() { valid = false; }
+    bool ok() const { return valid; }
+    bool atEnd() const { return position == end; }
+};
+
+const size_t MIN_VEHICLE_BYTES = 1 + 1 + 1 + 4 + 8 + 5 * 4 + 1;
+
+void writeVehicle(SnapshotWriter& writer, const Vehicle& vehicle,
+                  float x, float y, float targetX, float targetY, float speed,
+                  bool moving, bool atStop) {
+    std::string plate = PlateRegistry::lookup(vehicle.getPlateId());
+    if (plate.size() > 255) plate.resize(255);
+    writer.put(static_cast<uint8_t>(plate.size()));
+    writer.putBytes(plate.data(), plate.size());
+    writer.put(vehicle.getRoadName());
+    writer.put(static_cast<uint8_t>(vehicle.getLaneNumber()));
+    writer.put(static_cast<int32_t>(vehicle.getTurnStage()));
+    writer.put(vehicle.getEntryTime());
+    writer.put(x);
+    writer.put(y);
+    writer.put(targetX);
+    writer.put(targetY);
+    writer.put(speed);
+    writer.put(static_cast<uint8_t>((moving ? 1 : 0) | (atStop ? 2 : 0)));
+}
+
+void writeVehicle(SnapshotWriter& writer, const Vehicle& vehicle) {
+    writeVehicle(writer, vehicle, vehicle.getX(), vehicle.getY(),
+                 vehicle.getTargetX(), vehicle.getTargetY(), vehicle.getSpeed(),
+                 vehicle.getIsMoving(), vehicle.getAtStop());
+}
+
+bool readVehicle(SnapshotReader& reader, char expectedRoad, Vehicle& out) {
+    uint8_t plateLength = 0;
+    char plate[255];
+    char road = 0;
+    uint8_t lane = 0;
+    int32_t turnStage = 0;
+    double entryTime = 0.0;
+    float x, y, targetX, targetY, speed;
+    uint8_t flags = 0;
+
+    reader.get(plateLength);
+    reader.getBytes(plate, plateLength);
+    reader.get(road);
+    reader.get(lane);
+    reader.get(turnStage);
+    reader.get(entryTime);
+    reader.get(x);
+    reader.get(y);
+    reader.get(targetX);
+    reader.get(targetY);
+    reader.get(speed);
+    if (!reader.get(flags)) {
+        return false;
+    }
+    if (road < 'A' || road > 'D' || (expectedRoad != 0 && road != expectedRoad)
+        || lane < 1 || lane > 3) {
+        reader.fail();
+        return false;
+    }
+
+    out = Vehicle(PlateRegistry::intern(plate, plateLength), road, lane);
+    out.setTurnStage(turnStage);
+    out.setEntryTime(entryTime);
+    out.setPosition(x, y);
+    out.setTarget(targetX, targetY);
+    out.setSpeed(speed);
+    out.setMoving((flags & 1) != 0);
+    out.setAtStop((flags & 2) != 0);
+    return true;
+}
+
+void writeRoad(SnapshotWriter& writer, const Queue<Vehicle>& queue,
+               const std::vector<AnimatedVehicle>& active, const KinematicsArrays& kinematics,
+               const LaneIndex* laneOrder) {
+    writer.put(static_cast<uint32_t>(queue.getSize()));
+    for (int i = 0; i < queue.getSize(); i++) {
+        writeVehicle(writer, queue.at(i));
+    }
+
+    writer.put(static_cast<uint32_t>(active.size()));
+    evaluatePositions(kinematics);
+    for (size_t i = 0; i < active.size(); i++) {
+        const AnimatedVehicle& animated = active[i];
+        writeVehicle(writer, animated.vehicle,
+                     kinematics.x[i], kinematics.y[i],
+                     kinematics.targetX[i], kinematics.targetY[i], kinematics.speed[i],
+                     kinematics.moving[i] != 0, kinematics.atStop[i] != 0);
+        writer.put(static_cast<uint8_t>((animated.isActive ? 1 : 0)
+                                        | (animated.hasPassedIntersection ? 2 : 0)));
+        writer.put(static_cast<int64_t>(animated.laneSequence));
+        writer.put(static_cast<int32_t>(animated.queueSlot));
+        writer.put(animated.stopLineTime);
+    }
+
+    for (int lane = 0; lane < 3; lane++) {
+        const LaneIndex& order = laneOrder[lane];
+        writer.put(static_cast<int64_t>(order.getHeadSequence()));
+        writer.put(static_cast<uint32_t>(order.slotCount()));
+        for (int i = 0; i < order.slotCount(); i++) {
+            writer.put(static_cast<int32_t>(order.slotAt(i)));
+        }
+    }
+}
+
+bool readRoad(SnapshotReader& reader, char road, Queue<Vehicle>& queue,
+              std::vector<AnimatedVehicle>& active, KinematicsArrays& kinematics,
+              LaneIndex* laneOrder) {
+    uint32_t queued = 0;
+    if (!reader.getCount(queued, MIN_VEHICLE_BYTES)) return false;
+    queue.reserve(queued);
+    Vehicle vehicle(0u, road, 1);
+    for (uint32_t i = 0; i < queued; i++) {
+        if (!readVehicle(reader, road, vehicle)) return false;
+        queue.enqueue(vehicle);
+    }
+
+    uint32_t activeCount = 0;
+    if (!reader.getCount(activeCount, MIN_VEHICLE_BYTES + 1 + 8 + 4 + 8)) return false;
+    active.reserve(activeCount);
+    for (uint32_t i = 0; i < activeCount; i++) {
+        uint8_t flags = 0;
+        int64_t laneSequence = 0;
+        int32_t queueSlot = 0;
+        double stopLineTime = -1.0;
+        if (!readVehicle(reader, road, vehicle)) return false;
+        reader.get(flags);
+        reader.get(laneSequence);
+        reader.get(queueSlot);
+        reader.get(stopLineTime);
+        if (!reader.ok()) return false;
+
+        kinematics.push(vehicle);
+        active.push_back(AnimatedVehicle(vehicle));
+        AnimatedVehicle& animated = active.back();
+        animated.isActive = (flags & 1) != 0;
+        animated.hasPassedIntersection = (flags & 2) != 0;
+        animated.laneSequence = laneSequence;
+        animated.queueSlot = queueSlot;
+        animated.stopLineTime = stopLineTime;
+    }
+
+    std::vector<int> slots;
+    for (int lane = 0; lane < 3; lane++) {
+        int64_t head = 0;
+        uint32_t slotCount = 0;
+        reader.get(head);
+        if (!reader.getCount(slotCount, 4)) return false;
+        slots.resize(slotCount);
+        for (uint32_t i = 0; i < slotCount; i++) {
+            int32_t index = 0;
+            reader.get(index);
+            if (index >= static_cast<int32_t>(activeCount)) {
+                reader.fail();
+            }
+            slots[i] = index < 0 ? -1 : index;
+        }
+        if (!reader.ok()) return false;
+        laneOrder[lane].assign(head, slots);
+    }
+    return true;
+}
+
+}
+
+void TrafficManager::writeSnapshot(std::vector<char>& out) const {
+    out.clear();
+    SnapshotWriter writer(out);
+
+    writer.putBytes(SNAPSHOT_MAGIC, 4);
+    writer.put(SNAPSHOT_VERSION);
+    writer.put(static_cast<uint16_t>(0));
+    writer.put(static_cast<int32_t>(totalVehiclesProcessed));
+    writer.put(static_cast<int32_t>(retiredSinceCleanup));
+    writer.put(trafficLight.getCurrentLane());
+    writer.put(static_cast<uint8_t>(trafficLight.isPriorityMode() ? 1 : 0));
+    writer.put(greenElapsed);
+    writer.put(sinceDischarge);
+    writer.put(static_cast<int32_t>(phaseReleases));
+    writer.put(static_cast<uint8_t>(dischargeStarted ? 1 : 0));
+    for (int road = 0; road < 4; road++) {
+        writer.put(static_cast<int64_t>(dischargeStats[road].released));
+        writer.put(dischargeStats[road].greenSeconds);
+        writer.put(dischargeStats[road].queuedGreenSeconds);
+    }
+    writer.put(simTime);
+
+    writeRoad(writer, laneA, activeVehiclesA, kinematicsA, laneOrderA);
+    writeRoad(writer, laneB, activeVehiclesB, kinematicsB, laneOrderB);
+    writeRoad(writer, laneC, activeVehiclesC, kinematicsC, laneOrderC);
+    writeRoad(writer, laneD, activeVehiclesD, kinematicsD, laneOrderD);
+
+    writer.put(static_cast<uint32_t>(exitedVehicles.size()));
+    for (const auto& exited : exitedVehicles) {
+        writeVehicle(writer, exited.vehicle);
+        writer.put(exited.nextRoad);
+    }
+}
+
+bool TrafficManager::readSnapshot(const char* data, size_t size) {
+    SnapshotReader reader(data, size);
+
+    char magic[4];
+    uint16_t version = 0;
+    uint16_t reserved = 0;
+    reader.getBytes(magic, 4);
+    reader.get(version);
+    reader.get(reserved);
+    if (!reader.ok() || std::memcmp(magic, SNAPSHOT_MAGIC, 4) != 0 || version != SNAPSHOT_VERSION) {
+        std::cerr << "Error: not a supported TrafficManager snapshot" << std::endl;
+        return false;
+    }
+
+    // Build the new state on the side so a bad snapshot changes nothing
+    TrafficManager loaded;
+    int32_t processed = 0;
+    int32_t retired = 0;
+    char lightLane = 0;
+    uint8_t priority = 0;
+    reader.get(processed);
+    reader.get(retired);
+    reader.get(lightLane);
+    reader.get(priority);
+    int32_t releases = 0;
+    reader.get(loaded.greenElapsed);
+    reader.get(loaded.sinceDischarge);
+    reader.get(releases);
+    loaded.phaseReleases = releases;
+    uint8_t started = 0;
+    reader.get(started);
+    loaded.dischargeStarted = started != 0;
+    for (int road = 0; road < 4; road++) {
+        int64_t released = 0;
+        reader.get(released);
+        reader.get(loaded.dischargeStats[road].greenSeconds);
+        reader.get(loaded.dischargeStats[road].queuedGreenSeconds);
+        loaded.dischargeStats[road].released = released;
+    }
+    reader.get(loaded.simTime);
+    if (!reader.ok() || lightLane < 'A' || lightLane > 'D') {
+        std::cerr << "Error: snapshot header is damaged" << std::endl;
+        return false;
+    }
+    loaded.totalVehiclesProcessed = processed;
+    loaded.retiredSinceCleanup = retired;
+    loaded.trafficLight.restore(lightLane, priority != 0);
+
+    bool roadsOk = readRoad(reader, 'A', loaded.laneA, loaded.activeVehiclesA,
+                            loaded.kinematicsA, loaded.laneOrderA)
+                && readRoad(reader, 'B', loaded.laneB, loaded.activeVehiclesB,
+                            loaded.kinematicsB, loaded.laneOrderB)
+                && readRoad(reader, 'C', loaded.laneC, loaded.activeVehiclesC,
+                            loaded.kinematicsC, loaded.laneOrderC)
+                && readRoad(reader, 'D', loaded.laneD, loaded.activeVehiclesD,
+                            loaded.kinematicsD, loaded.laneOrderD);
+
+    uint32_t exitedCount = 0;
+    if (roadsOk && reader.getCount(exitedCount, MIN_VEHICLE_BYTES + 1)) {
+        Vehicle vehicle(0u, 'A', 1);
+        for (uint32_t i = 0; i < exitedCount && reader.ok(); i++) {
+            char nextRoad = 0;
+            if (readVehicle(reader, 0, vehicle) && reader.get(nextRoad)) {
+                loaded.exitedVehicles.push_back(ExitedVehicle(vehicle, nextRoad));
+            }
+        }
+    }
+
+    if (!roadsOk || !reader.ok() || !reader.atEnd()) {
+        std::cerr << "Error: snapshot is truncated or damaged" << std::endl;
+        return false;
+    }
+
+    // Settings stay as they are; only the simulation state is replaced
+    loaded.verbose = verbose;
+    loaded.signalControl = signalControl;
+    loaded.actuatedTiming = actuatedTiming;
+    loaded.dischargeMode = dischargeMode;
+    loaded.dischargeTiming = dischargeTiming;
+    loaded.maxActivePerRoad = maxActivePerRoad;
+    loaded.collectExits = collectExits;
+    loaded.laneFileFormat = laneFileFormat;
+    loaded.traceRecorder = traceRecorder;
+    *this = std::move(loaded);
+    return true;
+}
+
+bool TrafficManager::saveSnapshot(const std::string& filename) const {
+    std::vector<char> data;
+    writeSnapshot(data);
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: cannot create snapshot " << filename << std::endl;
+        return false;
+    }
+    file.write(data.data(), data.size());
+    if (!file.good()) {
+        std::cerr << "Error: writing snapshot " << filename << " failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TrafficManager::loadSnapshot(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: cannot open snapshot " << filename << std::endl;
+        return false;
+    }
+    std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                           std::istreambuf_iterator<char>());
+    return readSnapshot(data.data(), data.size());
+}
@@ -0,0 +1,278 @@
+#include "TrafficMetrics.h"
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+
+// Lower edge of the first logarithmic bucket
+static const double HISTOGRAM_FLOOR = 0.001;
+
+LatencyHistogram::LatencyHistogram() : count(0), sum(0.0), maxValue(0.0) {
+    for (int i = 0; i < BUCKETS; i++) {
+        counts[i] = 0;
+    }
+}
+
+// Bucket 0 holds everything below the floor, the last one everything above
+// the top octave
+int LatencyHistogram::bucketFor(double seconds) {
+    if (!(seconds >= HISTOGRAM_FLOOR)) {
+        return 0;
+    }
+    int bucket = 1 + static_cast<int>(std::floor(std::log2(seconds / HISTOGRAM_FLOOR) * SUB_BUCKETS));
+    return (bucket < BUCKETS - 1) ? bucket : BUCKETS - 1;
+}
+
+double LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket <= 0) {
+        return HISTOGRAM_FLOOR;
+    }
+    return HISTOGRAM_FLOOR * std::exp2(static_cast<double>(bucket) / SUB_BUCKETS);
+}
+
+void LatencyHistogram::record(double seconds) {
+    if (seconds < 0.0) {
+        seconds = 0.0;
+    }
+    counts[bucketFor(seconds)]++;
+    count++;
+    sum += seconds;
+    if (seconds > maxValue) {
+        maxValue = seconds;
+    }
+}
+
+double LatencyHistogram::percentile(double q) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    // Rank of the sample the quantile falls on, 1-based
+    long long rank = static_cast<long long>(std::ceil(q * count));
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    long long seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            double bound = bucketUpperBound(i);
+            return (bound < maxValue) ? bound : maxValue;
+        }
+    }
+    return maxValue;
+}
+
+LaneMetrics& TrafficMetrics::at(char road, int lane) {
+    int roadIndex = (road >= 'A' && road <= 'D') ? road - 'A' : 0;
+    int laneIndex = (lane >= 1 && lane <= 3) ? lane - 1 : 0;
+    return lanes[roadIndex][laneIndex];
+}
+
+const LaneMetrics& TrafficMetrics::at(char road, int lane) const {
+    return const_cast<TrafficMetrics*>(this)->at(road, lane);
+}
+
+namespace {
+
+struct HistogramField {
+    const char* name;
+    const char* help;
+    LatencyHistogram LaneMetrics::*histogram;
+};
+
+const HistogramField HISTOGRAM_FIELDS[] = {
+    {"traffic_queue_time_seconds", "Time from arrival until spawned onto the road",
+     &LaneMetrics::queueTime},
+    {"traffic_stop_delay_seconds", "Time stopped at the stop line until released (lane 2)",
+     &LaneMetrics::stopDelay},
+    {"traffic_system_time_seconds", "Time from arrival until leaving the intersection",
+     &LaneMetrics::systemTime},
+};
+
+struct CounterField {
+    const char* name;
+    const char* help;
+    long long LaneMetrics::*counter;
+};
+
+const CounterField COUNTER_FIELDS[] = {
+    {"traffic_arrived_total", "Vehicles that arrived at the intersection", &LaneMetrics::arrived},
+    {"traffic_released_total", "Vehicles that crossed the stop line", &LaneMetrics::released},
+    {"traffic_exited_total", "Vehicles that left the intersection", &LaneMetrics::exited},
+};
+
+const double QUANTILES[] = {0.5, 0.95, 0.99};
+
+}
+
+void TrafficMetrics::writePrometheus(std::ostream& out, double simTime) const {
+    const char roads[] = {'A', 'B', 'C', 'D'};
+
+    out << "# HELP traffic_sim_time_seconds Simulated time of this export\n"
+        << "# TYPE traffic_sim_time_seconds gauge\n"
+        << "traffic_sim_time_seconds " << simTime << "\n";
+
+    for (const CounterField& field : COUNTER_FIELDS) {
+        out << "# HELP " << field.name << " " << field.help << "\n"
+            << "# TYPE " << field.name << " counter\n";
+        for (char road : roads) {
+            for (int lane = 1; lane <= 3; lane++) {
+                out << field.name << "{road=\"" << road << "\",lane=\"" << lane << "\"} "
+                    << at(road, lane).*field.counter << "\n";
+            }
+        }
+    }
+
+    for (const HistogramField& field : HISTOGRAM_FIELDS) {
+        out << "# HELP " << field.name << " " << field.help << "\n"
+            << "# TYPE " << field.name << " summary\n";
+        for (char road : roads) {
+            for (int lane = 1; lane <= 3; lane++) {
+                const LatencyHistogram& histogram = at(road, lane).*field.histogram;
+                for (double q : QUANTILES) {
+                    out << field.name << "{road=\"" << road << "\",lane=\"" << lane
+                        << "\",quantile=\"" << q << "\"} " << histogram.percentile(q) << "\n";
+                }
+                out << field.name << "_sum{road=\"" << road << "\",lane=\"" << lane << "\"} "
+                    << histogram.getSum() << "\n"
+                    << field.name << "_count{road=\"" << road << "\",lane=\"" << lane << "\"} "
+                    << histogram.getCount() << "\n";
+            }
+        }
+
+        out << "# HELP " << field.name << "_max Largest value recorded\n"
+            << "# TYPE " << field.name << "_max gauge\n";
+        for (char road : roads) {
+            for (int lane = 1; lane <= 3; lane++) {
+                out << field.name << "_max{road=\"" << road << "\",lane=\"" << lane << "\"} "
+                    << (at(road, lane).*field.histogram).getMax() << "\n";
+            }
+        }
+    }
+}
+
+void TrafficMetrics::writeCsvHeader(std::ostream& out) {
+    out << "sim_time,road,lane,arrived,released,exited";
+    const char* names[] = {"queue", "stop", "system"};
+    for (const char* name : names) {
+        out << "," << name << "_p50," << name << "_p95," << name << "_p99," << name << "_max";
+    }
+    out << "\n";
+}
+
+void TrafficMetrics::writeCsvRows(std::ostream& out, double simTime) const {
+    const char roads[] = {'A', 'B', 'C', 'D'};
+
+    for (char road : roads) {
+        for (int lane = 1; lane <= 3; lane++) {
+            const LaneMetrics& metrics = at(road, lane);
+            out << simTime << "," << road << "," << lane << "," << metrics.arrived << ","
+                << metrics.released << "," << metrics.exited;
+            for (const HistogramField& field : HISTOGRAM_FIELDS) {
+                const LatencyHistogram& histogram = metrics.*field.histogram;
+                for (double q : QUANTILES) {
+                    out << "," << histogram.percentile(q);
+                }
+                out << "," << histogram.getMax();
+            }
+            out << "\n";
+        }
+    }
+}
+
+MetricsExporter::MetricsExporter() : interval(10.0), nextExport(0.0), exportCount(0) {
+}
+
+bool MetricsExporter::open(const std::string& prometheusFile, const std::string& csvFile, double intervalSeconds) {
+    prometheusPath = prometheusFile;
+    interval = (intervalSeconds > 0.0) ? intervalSeconds : 10.0;
+    nextExport = interval;
+    exportCount = 0;
+
+    if (csv.is_open()) {
+        csv.close();
+    }
+    if (!prometheusPath.empty()) {
+        // Every export goes through the .tmp file, so a directory that
+        // cannot take it fails here rather than on each export
+        std::string tempPath = prometheusPath + ".tmp";
+        std::ofstream probe(tempPath, std::ios::trunc);
+        if (!probe.is_open()) {
+            std::cerr << "Error: cannot create metrics file " << tempPath << std::endl;
+            prometheusPath.clear();
+            return false;
+        }
+        probe.close();
+        std::remove(tempPath.c_str());
+    }
+    if (!csvFile.empty()) {
+        csv.open(csvFile, std::ios::trunc);
+        if (!csv.is_open()) {
+            std::cerr << "Error: cannot create metrics file " << csvFile << std::endl;
+            return false;
+        }
+        TrafficMetrics::writeCsvHeader(csv);
+    }
+    return true;
+}
+
+bool MetricsExporter::isOpen() const {
+    return !prometheusPath.empty() || csv.is_open();
+}
+
+void MetricsExporter::update(const TrafficMetrics& metrics, double simTime) {
+    if (simTime < nextExport) {
+        return;
+    }
+    exportNow(metrics, simTime);
+    // Stay on the interval grid even if a step overshot it
+    while (nextExport <= simTime) {
+        nextExport += interval;
+    }
+}
+
+void MetricsExporter::exportNow(const TrafficMetrics& metrics, double simTime) {
+    bool written = true;
+    if (!prometheusPath.empty()) {
+        // Written aside and renamed over the old file, so a scraper never
+        // sees a half-written export
+        std::string tempPath = prometheusPath + ".tmp";
+        std::ofstream out(tempPath, std::ios::trunc);
+        metrics.writePrometheus(out, simTime);
+        out.close();
+
+        if (!out) {
+            std::cerr << "Error: writing metrics to " << tempPath << " failed" << std::endl;
+            written = false;
+        } else {
+#ifdef _WIN32
+            // rename() will not replace an existing file here
+            std::remove(prometheusPath.c_str());
+#endif
+            if (std::rename(tempPath.c_str(), prometheusPath.c_str()) != 0) {
+                std::cerr << "Error: cannot replace " << prometheusPath << std::endl;
+                written = false;
+            }
+        }
+    }
+
+    if (csv.is_open()) {
+        metrics.writeCsvRows(csv, simTime);
+        csv.flush();
+        if (!csv) {
+            std::cerr << "Error: writing metrics rows failed" << std::endl;
+            written = false;
+        }
+    }
+    if (written) {
+        exportCount++;
+    }
+}
+
+double MetricsExporter::getNextExportTime() const {
+    return nextExport;
+}
+
+long long MetricsExporter::getExportCount() const {
+    return exportCount;
+}
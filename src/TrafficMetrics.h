@@ -0,0 +1,103 @@
+#ifndef TRAFFICMETRICS_H
+#define TRAFFICMETRICS_H
+
+#include <string>
+#include <fstream>
+#include <ostream>
+
+// Latency histogram with logarithmic buckets: four per doubling from 1 ms
+// up to about 4.6 hours, plus one bucket for anything shorter. Recording is
+// a log2 and an increment, so it is cheap enough for every vehicle, and a
+// percentile is accurate to the bucket width (about 19%). The exact
+// maximum is kept separately.
+class LatencyHistogram {
+public:
+    enum { SUB_BUCKETS = 4, OCTAVES = 24, BUCKETS = SUB_BUCKETS * OCTAVES + 2 };
+
+private:
+    long long counts[BUCKETS];
+    long long count;
+    double sum;
+    double maxValue;
+
+public:
+    LatencyHistogram();
+
+    void record(double seconds);
+    // Upper bound of the bucket holding the q-quantile (0 < q <= 1), capped
+    // at the largest value seen; 0 when empty
+    double percentile(double q) const;
+
+    long long getCount() const { return count; }
+    double getSum() const { return sum; }
+    double getMax() const { return maxValue; }
+
+    static double bucketUpperBound(int bucket);
+    static int bucketFor(double seconds);
+};
+
+// Counters and latencies of one (road, lane). Times are simulated seconds:
+//   queueTime   arrival -> spawned onto the road (waiting behind the cap)
+//   stopDelay   stopped at the stop line or held by the red -> released
+//               (lane 2 only; lanes 1 and 3 never stop)
+//   systemTime  arrival -> left the world
+struct LaneMetrics {
+    long long arrived;
+    long long released;    // crossed the stop line, every lane
+    long long exited;
+    LatencyHistogram queueTime;
+    LatencyHistogram stopDelay;
+    LatencyHistogram systemTime;
+
+    LaneMetrics() : arrived(0), released(0), exited(0) {}
+};
+
+class TrafficMetrics {
+private:
+    LaneMetrics lanes[4][3];
+
+public:
+    LaneMetrics& at(char road, int lane);
+    const LaneMetrics& at(char road, int lane) const;
+
+    // Prometheus text exposition format: counters per (road, lane) and each
+    // histogram as a summary with p50/p95/p99 plus a max gauge
+    void writePrometheus(std::ostream& out, double simTime) const;
+    // One row per (road, lane) for the current time, see writeCsvHeader
+    void writeCsvRows(std::ostream& out, double simTime) const;
+    static void writeCsvHeader(std::ostream& out);
+};
+
+// Writes a TrafficManager's metrics on a simulated-time interval: the
+// Prometheus file is replaced each time (written aside and renamed, so a
+// scraper never reads half a file) and the CSV gets rows appended.
+class MetricsExporter {
+private:
+    std::string prometheusPath;
+    std::ofstream csv;
+    double interval;
+    double nextExport;
+    long long exportCount;
+
+    MetricsExporter(const MetricsExporter&);
+    MetricsExporter& operator=(const MetricsExporter&);
+
+public:
+    MetricsExporter();
+
+    // Either path may be empty; interval in simulated seconds. Fails if
+    // either file (the Prometheus one's .tmp included) cannot be created.
+    bool open(const std::string& prometheusFile, const std::string& csvFile, double intervalSeconds);
+    bool isOpen() const;
+
+    // Exports when the interval has passed since the last export
+    void update(const TrafficMetrics& metrics, double simTime);
+    void exportNow(const TrafficMetrics& metrics, double simTime);
+    // Simulated time update() will export at next
+    double getNextExportTime() const;
+
+    // Exports whose every file was written
+    long long getExportCount() const;
+};
+
+#endif
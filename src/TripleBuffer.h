@@ -0,0 +1,59 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// Latest-value hand-over between exactly one writer thread and one reader
+// thread. Three slots: the writer fills its back slot and swaps it with the
+// middle one, the reader swaps the middle one with its front slot when a new
+// value is waiting. Neither side ever blocks or waits for the other, the
+// reader always gets the most recent complete value, and a value in the
+// front slot stays untouched until the reader asks for the next. Values the
+// reader never picked up are simply overwritten. Slots are reused, so a T
+// holding vectors stops allocating once their capacity has grown.
+template <typename T>
+class TripleBuffer {
+private:
+    // The middle slot index in the low bits, NEW_VALUE while the reader has
+    // not taken it yet
+    enum { INDEX_MASK = 3, NEW_VALUE = 4 };
+
+    T slots[3];
+    alignas(64) std::atomic<int> middle;
+    alignas(64) int back;    // writer's slot
+    alignas(64) int front;   // reader's slot
+
+    TripleBuffer(const TripleBuffer&);
+    TripleBuffer& operator=(const TripleBuffer&);
+
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+
+    // Writer side: fill this, then publish()
+    T& writeSlot() {
+        return slots[back];
+    }
+
+    void publish() {
+        int previous = middle.exchange(back | NEW_VALUE, std::memory_order_acq_rel);
+        back = previous & INDEX_MASK;
+    }
+
+    // Reader side: moves to the newest published value if there is one.
+    // Returns false when nothing new was published since the last call.
+    bool update() {
+        if ((middle.load(std::memory_order_relaxed) & NEW_VALUE) == 0) {
+            return false;
+        }
+        int previous = middle.exchange(front, std::memory_order_acq_rel);
+        front = previous & INDEX_MASK;
+        return true;
+    }
+
+    // The value update() last moved to (default-constructed before that)
+    const T& readSlot() const {
+        return slots[front];
+    }
+};
+
+#endif
@@ -1,13 +1,18 @@
 #include "Vehicle.h"
 #include <iostream>
 
-Vehicle::Vehicle(std::string plate, char road, int lane)
-    : licensePlate(plate), roadName(road), laneNumber(lane),
-      x(0), y(0), targetX(0), targetY(0),
-      isMoving(false), speed(100.0f),
-      turnStage(0)
+Vehicle::Vehicle(const std::string& plate, char road, int lane)
+    : entryTime(0.0), plateId(PlateRegistry::intern(plate)), turnStage(0), laneNumber(lane),
+      x(0), y(0), speed(100.0f), targetX(0), targetY(0),
+      roadName(road), isMoving(false)
+{
+}
+
+Vehicle::Vehicle(uint32_t plateId, char road, int lane)
+    : entryTime(0.0), plateId(plateId), turnStage(0), laneNumber(lane),
+      x(0), y(0), speed(100.0f), targetX(0), targetY(0),
+      roadName(road), isMoving(false)
 {
-    this->entryTime = std::time(nullptr);
 }
 
 
@@ -22,7 +27,7 @@ void Vehicle::setTurnStage(int stage) {
 
 std::string Vehicle::getLicensePlate() const
 {
-    return licensePlate;
+    return PlateRegistry::lookup(plateId);
 }
 
 char Vehicle::getRoadName() const
@@ -35,7 +40,7 @@ int Vehicle::getLaneNumber() const
     return laneNumber;
 }
 
-std::time_t Vehicle::getEntryTime() const
+double Vehicle::getEntryTime() const
 {
     return entryTime;
 }
@@ -45,50 +50,10 @@ char Vehicle::getLaneName() const
     return roadName;  
 }
 
-void Vehicle::updatePosition(float deltaTime)
-{
-    if (!isMoving) return;
-
-    float dx = targetX - x;
-    float dy = targetY - y;
-
-    float distance = std::sqrt(dx * dx + dy * dy);
-
-    // Increased threshold from 1.0f to 2.0f for better stability
-    if (distance < 2.0f) {
-        x = targetX;
-        y = targetY;
-        isMoving = false;
-        return;
-    }
-
-    // Calculate movement
-    float moveDistance = speed * deltaTime;
-    
-    // Prevent overshooting
-    if (moveDistance > distance) {
-        moveDistance = distance;
-    }
-
-    float dirX = dx / distance;
-    float dirY = dy / distance;
-
-    x += dirX * moveDistance;
-    y += dirY * moveDistance;
-}
-
-bool Vehicle::hasReachedTarget() const
-{
-    float dx = targetX - x;
-    float dy = targetY - y;
-    float distance = std::sqrt(dx * dx + dy * dy);
-    return distance < 2.0f;
-}
-
 void Vehicle::display() const 
 {
-    std::cout << "License Plate: " << licensePlate 
+    std::cout << "License Plate: " << getLicensePlate() 
               << ", Road: " << roadName 
               << ", Lane: " << laneNumber 
-              << ", Entry Time: " << entryTime << std::endl;
+              << ", Entry Time: " << entryTime << " s" << std::endl;
 }
\ No newline at end of file
@@ -2,33 +2,41 @@
 #define VEHICLE_H
 
 #include <string>
-#include <ctime>
 #include <cmath>
+#include <cstdint>
+#include "PlateRegistry.h"
 
 class Vehicle {
 private:
     
-    bool turning = false;
+    // Widest members first and the flags packed at the end: 48 bytes on
+    // 64-bit targets, small enough that queues move vehicles cheaply
+    double entryTime;   // simulated seconds it arrived, set by TrafficManager
+    uint32_t plateId;   // see PlateRegistry
     int turnStage = 0;
-    std::string licensePlate;
-    char roadName;      
     int laneNumber;     
-    std::time_t entryTime;
     
-   
+    // Motion state the vehicle is placed on its road with. Once it is active
+    // KinematicsArrays owns its motion and these are not updated; queued
+    // vehicles and snapshots of them use these.
     float x, y;              
     float speed;           
-    bool isMoving;           
     float targetX, targetY;  
+    char roadName;      
+    bool isMoving;           
     bool isAtStop = false;
     
 public:
-    Vehicle(std::string plate, char road, int lane);
+    Vehicle(const std::string& plate, char road, int lane);
+    Vehicle(uint32_t plateId, char road, int lane);
     
+    // Resolved through PlateRegistry; meant for display, not hot paths
     std::string getLicensePlate() const;
+    uint32_t getPlateId() const { return plateId; }
     char getRoadName() const;
     int getLaneNumber() const;
-    std::time_t getEntryTime() const;
+    double getEntryTime() const;
+    void setEntryTime(double simSeconds) { entryTime = simSeconds; }
     char getLaneName() const;
     int getTurnStage() const;
 void setTurnStage(int stage);
@@ -38,6 +46,8 @@ void setTurnStage(int stage);
     float getY() const { return y; }
     void setPosition(float newX, float newY) { x = newX; y = newY; }
     void setTarget(float tx, float ty) { targetX = tx; targetY = ty; }
+    float getTargetX() const { return targetX; }
+    float getTargetY() const { return targetY; }
     void setMoving(bool moving) { isMoving = moving; }
     bool getIsMoving() const { return isMoving; }
     float getSpeed() const { return speed; }
@@ -45,9 +55,6 @@ void setTurnStage(int stage);
     void setAtStop(bool atStop) { isAtStop = atStop; }
     bool getAtStop() const { return isAtStop; }
     
-    void updatePosition(float deltaTime);
-    bool hasReachedTarget() const;
-    
     void display() const;
 };
 
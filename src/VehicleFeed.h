@@ -0,0 +1,38 @@
+#ifndef VEHICLEFEED_H
+#define VEHICLEFEED_H
+
+#include <string>
+#include <vector>
+#include "Vehicle.h"
+
+// Where TrafficGenerator publishes new arrivals. Without a sink the
+// generator appends to the lane text files as before.
+class VehicleSink {
+public:
+    virtual ~VehicleSink() {}
+    virtual bool publish(const std::string& plate, char road, int lane) = 0;
+    virtual void flush() {}
+};
+
+// Where the simulator takes new arrivals from, one batch per poll. Without a
+// source TrafficManager reads the lane text files as before.
+class VehicleSource {
+public:
+    virtual ~VehicleSource() {}
+    // Appends everything that arrived since the last poll; returns the count
+    virtual int poll(
+        std::vector<Vehicle>& lane_A,
+        std::vector<Vehicle>& lane_B,
+        std::vector<Vehicle>& lane_C,
+        std::vector<Vehicle>& lane_D
+    ) = 0;
+    // Simulated time of the coming poll, set by SimulationClock every step.
+    // Live feeds ignore it; a trace replay releases what is due by then.
+    virtual void advanceTo(double /*simSeconds*/) {}
+    // Simulated time of the next arrival, so EventClock can jump straight to
+    // it: negative when the source cannot know (live feeds), infinity once
+    // nothing more will come.
+    virtual double nextArrivalTime() const { return -1.0; }
+};
+
+#endif
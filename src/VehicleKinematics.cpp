@@ -0,0 +1,262 @@
+#include "VehicleKinematics.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define KINEMATICS_AVX 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define KINEMATICS_SSE2 1
+#endif
+
+static const double NEVER = std::numeric_limits<double>::infinity();
+
+KinematicsArrays::KinematicsArrays()
+    : clock(0.0), nextArrival(NEVER), stopReleased(true) {
+}
+
+// Starts the vehicle's segment at its origin now and works out when it
+// comes within reach of the target
+static void startSegment(KinematicsArrays& k, int i) {
+    float dx = k.targetX[i] - k.originX[i];
+    float dy = k.targetY[i] - k.originY[i];
+    float distance = std::sqrt(dx * dx + dy * dy);
+    k.length[i] = distance;
+    k.dirX[i] = distance > 0.0f ? dx / distance : 0.0f;
+    k.dirY[i] = distance > 0.0f ? dy / distance : 0.0f;
+    k.startTime[i] = k.clock;
+
+    if (!k.moving[i] || k.held[i] || k.speed[i] <= 0.0f) {
+        k.arrivalTime[i] = NEVER;
+        return;
+    }
+    float travel = distance - REACH_DISTANCE;
+    k.arrivalTime[i] = k.clock + (travel > 0.0f ? travel / k.speed[i] : 0.0);
+    k.nextArrival = std::min(k.nextArrival, k.arrivalTime[i]);
+}
+
+void KinematicsArrays::push(const Vehicle& vehicle) {
+    originX.push_back(vehicle.getX());
+    originY.push_back(vehicle.getY());
+    dirX.push_back(0.0f);
+    dirY.push_back(0.0f);
+    length.push_back(0.0f);
+    targetX.push_back(vehicle.getTargetX());
+    targetY.push_back(vehicle.getTargetY());
+    speed.push_back(vehicle.getSpeed());
+    startTime.push_back(clock);
+    arrivalTime.push_back(NEVER);
+    moving.push_back(vehicle.getIsMoving() ? 1 : 0);
+    atStop.push_back(vehicle.getAtStop() ? 1 : 0);
+    held.push_back(vehicle.getAtStop() && !stopReleased ? 1 : 0);
+    x.push_back(vehicle.getX());
+    y.push_back(vehicle.getY());
+    startSegment(*this, size() - 1);
+}
+
+void KinematicsArrays::setTarget(int index, float tx, float ty, float newSpeed) {
+    positionAt(index, originX[index], originY[index]);
+    targetX[index] = tx;
+    targetY[index] = ty;
+    speed[index] = newSpeed;
+    moving[index] = 1;
+    startSegment(*this, index);
+}
+
+void KinematicsArrays::releaseStop(int index) {
+    atStop[index] = 0;
+    if (held[index]) {
+        held[index] = 0;
+        startSegment(*this, index);
+    }
+}
+
+bool KinematicsArrays::setStopReleased(bool released) {
+    if (released == stopReleased) {
+        return false;
+    }
+    stopReleased = released;
+
+    int n = size();
+    for (int i = 0; i < n; i++) {
+        if (!atStop[i]) {
+            continue;
+        }
+        if (released) {
+            held[i] = 0;
+        } else {
+            positionAt(i, originX[i], originY[i]);
+            held[i] = 1;
+        }
+        // A held segment never arrives; a released one restarts from here
+        startSegment(*this, i);
+    }
+    return true;
+}
+
+void KinematicsArrays::takeArrivals(std::vector<int>& arrived) {
+    arrived.clear();
+    if (nextArrival > clock) {
+        return;
+    }
+
+    nextArrival = NEVER;
+    int n = size();
+    for (int i = 0; i < n; i++) {
+        if (arrivalTime[i] <= clock) {
+            originX[i] = targetX[i];
+            originY[i] = targetY[i];
+            moving[i] = 0;
+            arrivalTime[i] = NEVER;
+            arrived.push_back(i);
+        }
+        else if (arrivalTime[i] < nextArrival) {
+            nextArrival = arrivalTime[i];
+        }
+    }
+}
+
+void KinematicsArrays::positionAt(int index, float& px, float& py) const {
+    float travel = 0.0f;
+    if (moving[index] && !held[index]) {
+        travel = std::min(static_cast<float>(speed[index] * (clock - startTime[index])),
+                          length[index]);
+    }
+    px = originX[index] + dirX[index] * travel;
+    py = originY[index] + dirY[index] * travel;
+}
+
+void KinematicsArrays::moveElement(int from, int to) {
+    originX[to] = originX[from];
+    originY[to] = originY[from];
+    dirX[to] = dirX[from];
+    dirY[to] = dirY[from];
+    length[to] = length[from];
+    targetX[to] = targetX[from];
+    targetY[to] = targetY[from];
+    speed[to] = speed[from];
+    startTime[to] = startTime[from];
+    arrivalTime[to] = arrivalTime[from];
+    moving[to] = moving[from];
+    atStop[to] = atStop[from];
+    held[to] = held[from];
+    x[to] = x[from];
+    y[to] = y[from];
+}
+
+void KinematicsArrays::resize(int newSize) {
+    originX.resize(newSize);
+    originY.resize(newSize);
+    dirX.resize(newSize);
+    dirY.resize(newSize);
+    length.resize(newSize);
+    targetX.resize(newSize);
+    targetY.resize(newSize);
+    speed.resize(newSize);
+    startTime.resize(newSize);
+    arrivalTime.resize(newSize, NEVER);
+    moving.resize(newSize);
+    atStop.resize(newSize);
+    held.resize(newSize);
+    x.resize(newSize);
+    y.resize(newSize);
+}
+
+void KinematicsArrays::clear() {
+    resize(0);
+    nextArrival = NEVER;
+}
+
+// Scalar version of the kernel, also used for the tail the SIMD loops leave
+static void evaluateRange(const KinematicsArrays& k, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        k.positionAt(i, k.x[i], k.y[i]);
+    }
+}
+
+#if defined(KINEMATICS_AVX)
+
+void evaluatePositions(const KinematicsArrays& k) {
+    const int n = k.size();
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256d clock = _mm256_set1_pd(k.clock);
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 elapsedLow = _mm256_cvtpd_ps(_mm256_sub_pd(clock, _mm256_loadu_pd(&k.startTime[i])));
+        __m128 elapsedHigh = _mm256_cvtpd_ps(_mm256_sub_pd(clock, _mm256_loadu_pd(&k.startTime[i + 4])));
+        __m256 elapsed = _mm256_insertf128_ps(_mm256_castps128_ps256(elapsedLow), elapsedHigh, 1);
+
+        __m256 movingF = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&k.moving[i])));
+        __m256 heldF = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(&k.held[i])));
+        __m256 active = _mm256_andnot_ps(_mm256_cmp_ps(heldF, zero, _CMP_NEQ_OQ),
+                                         _mm256_cmp_ps(movingF, zero, _CMP_NEQ_OQ));
+
+        __m256 travel = _mm256_min_ps(_mm256_mul_ps(_mm256_loadu_ps(&k.speed[i]), elapsed),
+                                      _mm256_loadu_ps(&k.length[i]));
+        travel = _mm256_and_ps(active, travel);
+
+        __m256 nx = _mm256_add_ps(_mm256_loadu_ps(&k.originX[i]),
+                                  _mm256_mul_ps(_mm256_loadu_ps(&k.dirX[i]), travel));
+        __m256 ny = _mm256_add_ps(_mm256_loadu_ps(&k.originY[i]),
+                                  _mm256_mul_ps(_mm256_loadu_ps(&k.dirY[i]), travel));
+        _mm256_storeu_ps(&k.x[i], nx);
+        _mm256_storeu_ps(&k.y[i], ny);
+    }
+
+    evaluateRange(k, i, n);
+}
+
+const char* kinematicsKernelName() {
+    return "AVX";
+}
+
+#elif defined(KINEMATICS_SSE2)
+
+void evaluatePositions(const KinematicsArrays& k) {
+    const int n = k.size();
+    const __m128i zeroI = _mm_setzero_si128();
+    const __m128d clock = _mm_set1_pd(k.clock);
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 elapsedLow = _mm_cvtpd_ps(_mm_sub_pd(clock, _mm_loadu_pd(&k.startTime[i])));
+        __m128 elapsedHigh = _mm_cvtpd_ps(_mm_sub_pd(clock, _mm_loadu_pd(&k.startTime[i + 2])));
+        __m128 elapsed = _mm_movelh_ps(elapsedLow, elapsedHigh);
+
+        __m128i movingI = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&k.moving[i]));
+        __m128i heldI = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&k.held[i]));
+        // moving != 0 and held == 0
+        __m128 active = _mm_castsi128_ps(_mm_andnot_si128(_mm_cmpeq_epi32(movingI, zeroI),
+                                                          _mm_cmpeq_epi32(heldI, zeroI)));
+
+        __m128 travel = _mm_min_ps(_mm_mul_ps(_mm_loadu_ps(&k.speed[i]), elapsed),
+                                   _mm_loadu_ps(&k.length[i]));
+        travel = _mm_and_ps(active, travel);
+
+        __m128 nx = _mm_add_ps(_mm_loadu_ps(&k.originX[i]), _mm_mul_ps(_mm_loadu_ps(&k.dirX[i]), travel));
+        __m128 ny = _mm_add_ps(_mm_loadu_ps(&k.originY[i]), _mm_mul_ps(_mm_loadu_ps(&k.dirY[i]), travel));
+        _mm_storeu_ps(&k.x[i], nx);
+        _mm_storeu_ps(&k.y[i], ny);
+    }
+
+    evaluateRange(k, i, n);
+}
+
+const char* kinematicsKernelName() {
+    return "SSE2";
+}
+
+#else
+
+void evaluatePositions(const KinematicsArrays& k) {
+    evaluateRange(k, 0, k.size());
+}
+
+const char* kinematicsKernelName() {
+    return "scalar";
+}
+
+#endif
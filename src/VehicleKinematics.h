@@ -0,0 +1,75 @@
+#ifndef VEHICLEKINEMATICS_H
+#define VEHICLEKINEMATICS_H
+
+#include <vector>
+#include "Vehicle.h"
+
+// Distance below which a vehicle counts as having reached its target
+const float REACH_DISTANCE = 2.0f;
+
+// Motion state of the active vehicles on one road, stored one column per
+// field. Index i in every column belongs to the i-th AnimatedVehicle of the
+// same road.
+//
+// Every move is a straight segment at constant speed, so nothing is
+// integrated per tick. Setting a target records where the segment starts,
+// its direction and length, the time it started and the time the vehicle
+// comes within REACH_DISTANCE of the target; the position at any moment is
+// a pure function of the road's motion clock. advance() only moves the
+// clock, and takeArrivals() hands over the vehicles whose arrival time has
+// come. Vehicles flagged atStop are held where they are while their road is
+// red (setStopReleased(false)) and carry on when it turns green.
+struct KinematicsArrays {
+    std::vector<float> originX;    // position at startTime (where a held vehicle stands)
+    std::vector<float> originY;
+    std::vector<float> dirX;       // unit vector toward the target
+    std::vector<float> dirY;
+    std::vector<float> length;     // origin to target
+    std::vector<float> targetX;
+    std::vector<float> targetY;
+    std::vector<float> speed;
+    std::vector<double> startTime;
+    std::vector<double> arrivalTime;   // infinity while stopped or held
+    std::vector<int> moving;
+    std::vector<int> atStop;
+    std::vector<int> held;
+    // Positions as of the last evaluatePositions()
+    mutable std::vector<float> x;
+    mutable std::vector<float> y;
+
+    double clock;          // seconds of motion so far
+    double nextArrival;    // no arrival is due before this (it may be early)
+    bool stopReleased;     // atStop vehicles may move: their road has the green
+
+    KinematicsArrays();
+
+    int size() const { return static_cast<int>(originX.size()); }
+
+    // Append the motion state a Vehicle was initialised with
+    void push(const Vehicle& vehicle);
+    // New segment from wherever the vehicle is now
+    void setTarget(int index, float tx, float ty, float newSpeed);
+    // Clears atStop; the vehicle moves on regardless of the light
+    void releaseStop(int index);
+    // Holds or releases every atStop vehicle; returns true if that changed
+    bool setStopReleased(bool released);
+
+    void advance(float deltaTime) { clock += deltaTime; }
+    // Indices, in order, of the vehicles that came within REACH_DISTANCE of
+    // their target by now. Each is placed on its target and stops moving.
+    void takeArrivals(std::vector<int>& arrived);
+    void positionAt(int index, float& px, float& py) const;
+
+    void moveElement(int from, int to);
+    void resize(int newSize);
+    void clear();
+};
+
+// Fills k.x and k.y with every vehicle's position at k.clock. Uses AVX or
+// SSE2 when the compiler targets them and a scalar loop otherwise.
+void evaluatePositions(const KinematicsArrays& k);
+
+// Name of the code path evaluatePositions was compiled with
+const char* kinematicsKernelName();
+
+#endif
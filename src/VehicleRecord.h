@@ -0,0 +1,105 @@
+#ifndef VEHICLERECORD_H
+#define VEHICLERECORD_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <chrono>
+#include "Vehicle.h"
+
+// Fixed-size, trivially copyable form of one arrival, used wherever vehicles
+// cross a process or file boundary. The plate is stored NUL-padded (plates
+// the generator makes are at most 10 characters); longer plates are cut.
+struct VehicleRecord {
+    enum { PLATE_SIZE = 12 };
+
+    char plate[PLATE_SIZE];
+    char road;
+    uint8_t lane;
+    uint8_t reserved[2];
+    uint64_t timestampNs;   // when the vehicle arrived (see VehicleFileHeader)
+
+    static VehicleRecord make(const std::string& licensePlate, char road, int lane,
+                              uint64_t timestampNs) {
+        VehicleRecord record;
+        std::memset(&record, 0, sizeof(record));
+        size_t length = licensePlate.size();
+        if (length > static_cast<size_t>(PLATE_SIZE)) length = PLATE_SIZE;
+        std::memcpy(record.plate, licensePlate.data(), length);
+        record.road = road;
+        record.lane = static_cast<uint8_t>(lane);
+        record.timestampNs = timestampNs;
+        return record;
+    }
+
+    std::string getPlate() const {
+        size_t length = 0;
+        while (length < static_cast<size_t>(PLATE_SIZE) && plate[length] != '\0') length++;
+        return std::string(plate, length);
+    }
+
+    bool isValid() const {
+        return road >= 'A' && road <= 'D' && lane >= 1 && lane <= 3;
+    }
+
+    Vehicle toVehicle() const {
+        size_t length = 0;
+        while (length < static_cast<size_t>(PLATE_SIZE) && plate[length] != '\0') length++;
+        return Vehicle(PlateRegistry::intern(plate, length), road, lane);
+    }
+};
+
+static_assert(sizeof(VehicleRecord) == 24, "VehicleRecord is an on-disk format");
+
+// First bytes of every binary lane file. Readers reject other magic values
+// and newer versions; records may grow in later versions, so readers step
+// by recordSize and use the fields they know.
+struct VehicleFileHeader {
+    enum { VERSION = 1 };
+    enum TimeBase { TIME_UNIX_NS = 0, TIME_SIMULATION_NS = 1 };
+
+    char magic[4];          // "TVRF"
+    uint16_t version;
+    uint16_t recordSize;
+    uint8_t timeBase;
+    uint8_t reserved[7];
+
+    static VehicleFileHeader make(TimeBase base = TIME_UNIX_NS) {
+        VehicleFileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, "TVRF", 4);
+        header.version = VERSION;
+        header.recordSize = sizeof(VehicleRecord);
+        header.timeBase = static_cast<uint8_t>(base);
+        return header;
+    }
+
+    bool isValid() const {
+        return std::memcmp(magic, "TVRF", 4) == 0
+            && version >= 1 && version <= VERSION
+            && static_cast<size_t>(recordSize) >= sizeof(VehicleRecord);
+    }
+};
+
+static_assert(sizeof(VehicleFileHeader) == 16, "VehicleFileHeader is an on-disk format");
+
+// How arrivals are stored in the lane files: the original "plate,road,lane"
+// text lines in lane_X.txt, or VehicleRecords after a header in lane_X.bin
+enum LaneFileFormat {
+    LANE_FORMAT_TEXT,
+    LANE_FORMAT_BINARY
+};
+
+inline std::string laneFileName(char road, LaneFileFormat format) {
+    return std::string("lane_") + road + (format == LANE_FORMAT_BINARY ? ".bin" : ".txt");
+}
+
+// Nanoseconds since the Unix epoch. Same clock in every process, so a
+// timestamp written by the generator can be compared with the simulator's.
+inline uint64_t epochNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+}
+
+#endif
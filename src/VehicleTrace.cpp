@@ -0,0 +1,170 @@
+#include "VehicleTrace.h"
+#include <iostream>
+#include <cmath>
+#include <limits>
+
+uint64_t simulationNanoseconds(double simSeconds) {
+    if (simSeconds <= 0.0) {
+        return 0;
+    }
+    // Rounded, so a recording and its replay map the same step to the same
+    // stamp even when the accumulated time is a hair off a whole nanosecond
+    return static_cast<uint64_t>(std::llround(simSeconds * 1e9));
+}
+
+TraceRecorder::TraceRecorder() : recordedCount(0) {
+}
+
+TraceRecorder::~TraceRecorder() {
+    close();
+}
+
+bool TraceRecorder::open(const std::string& filename) {
+    close();
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: cannot create trace " << filename << std::endl;
+        return false;
+    }
+
+    VehicleFileHeader header = VehicleFileHeader::make(VehicleFileHeader::TIME_SIMULATION_NS);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    path = filename;
+    recordedCount = 0;
+    pending.reserve(4096);
+    return file.good();
+}
+
+bool TraceRecorder::flushPending() {
+    if (!pending.empty()) {
+        file.write(reinterpret_cast<const char*>(pending.data()),
+                   pending.size() * sizeof(VehicleRecord));
+        pending.clear();
+    }
+    return file.good();
+}
+
+void TraceRecorder::close() {
+    if (!file.is_open()) {
+        return;
+    }
+    if (!flushPending()) {
+        std::cerr << "Error: writing trace " << path << " failed" << std::endl;
+    }
+    file.close();
+}
+
+bool TraceRecorder::isOpen() const {
+    return file.is_open();
+}
+
+bool TraceRecorder::record(const Vehicle& vehicle, double simSeconds) {
+    if (!file.is_open()) {
+        return false;
+    }
+
+    pending.push_back(VehicleRecord::make(PlateRegistry::lookup(vehicle.getPlateId()),
+                                          vehicle.getRoadName(), vehicle.getLaneNumber(),
+                                          simulationNanoseconds(simSeconds)));
+    recordedCount++;
+
+    if (pending.size() >= 4096) {
+        return flushPending();
+    }
+    return true;
+}
+
+long long TraceRecorder::getRecordedCount() const {
+    return recordedCount;
+}
+
+TraceReplay::TraceReplay()
+    : batchPosition(0), currentNs(0), exhausted(true), replayedCount(0) {
+}
+
+bool TraceReplay::open(const std::string& filename) {
+    if (!reader.open(filename)) {
+        std::cerr << "Error: cannot open trace " << filename << std::endl;
+        return false;
+    }
+    if (reader.getHeader().timeBase != VehicleFileHeader::TIME_SIMULATION_NS) {
+        std::cerr << "Error: " << filename << " holds wall-clock timestamps, not a recorded trace" << std::endl;
+        reader.close();
+        return false;
+    }
+
+    currentNs = 0;
+    exhausted = false;
+    replayedCount = 0;
+    refill();
+    return true;
+}
+
+void TraceReplay::refill() {
+    batch.resize(BATCH_RECORDS);
+    size_t count = reader.read(batch.data(), BATCH_RECORDS);
+    batch.resize(count);
+    batchPosition = 0;
+    if (count == 0) {
+        exhausted = true;
+        reader.close();
+    }
+}
+
+void TraceReplay::advanceTo(double simSeconds) {
+    currentNs = simulationNanoseconds(simSeconds);
+}
+
+// Stamp of the record poll() stopped at. At a batch boundary the next
+// record is not read yet, so report the current time and let a poll find it.
+double TraceReplay::nextArrivalTime() const {
+    if (exhausted) {
+        return std::numeric_limits<double>::infinity();
+    }
+    if (batchPosition == batch.size()) {
+        return currentNs / 1e9;
+    }
+    return batch[batchPosition].timestampNs / 1e9;
+}
+
+int TraceReplay::poll(std::vector<Vehicle>& lane_A,
+                      std::vector<Vehicle>& lane_B,
+                      std::vector<Vehicle>& lane_C,
+                      std::vector<Vehicle>& lane_D) {
+    int count = 0;
+
+    while (!exhausted) {
+        if (batchPosition == batch.size()) {
+            refill();
+            continue;
+        }
+
+        const VehicleRecord& record = batch[batchPosition];
+        if (record.timestampNs > currentNs) {
+            break;
+        }
+        batchPosition++;
+
+        if (!record.isValid()) {
+            continue;
+        }
+        switch (record.road) {
+            case 'A': lane_A.push_back(record.toVehicle()); break;
+            case 'B': lane_B.push_back(record.toVehicle()); break;
+            case 'C': lane_C.push_back(record.toVehicle()); break;
+            case 'D': lane_D.push_back(record.toVehicle()); break;
+        }
+        count++;
+    }
+
+    replayedCount += count;
+    return count;
+}
+
+bool TraceReplay::isFinished() const {
+    return exhausted;
+}
+
+long long TraceReplay::getReplayedCount() const {
+    return replayedCount;
+}
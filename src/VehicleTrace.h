@@ -0,0 +1,83 @@
+#ifndef VEHICLETRACE_H
+#define VEHICLETRACE_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include "VehicleFeed.h"
+#include "VehicleRecord.h"
+#include "FileReader.h"
+
+// Arrival traces: every vehicle a simulator took in, in the order it was
+// queued, stamped with the simulated time it arrived. A trace is one binary
+// file (a VehicleFileHeader with timeBase TIME_SIMULATION_NS, then
+// VehicleRecords), so a live run against the generator can be replayed later
+// with exactly the same demand, independent of wall-clock polling.
+
+uint64_t simulationNanoseconds(double simSeconds);
+
+class TraceRecorder {
+private:
+    std::ofstream file;
+    std::string path;
+    std::vector<VehicleRecord> pending;
+    long long recordedCount;
+
+    bool flushPending();
+
+    TraceRecorder(const TraceRecorder&);
+    TraceRecorder& operator=(const TraceRecorder&);
+
+public:
+    TraceRecorder();
+    ~TraceRecorder();
+
+    // Truncates the file and writes the header
+    bool open(const std::string& filename);
+    void close();
+    bool isOpen() const;
+
+    bool record(const Vehicle& vehicle, double simSeconds);
+
+    long long getRecordedCount() const;
+};
+
+// Feeds a recorded trace back as a VehicleSource. Nothing is released on
+// wall time: each poll hands over the records stamped at or before the time
+// passed to the last advanceTo(), so a SimulationClock can step through an
+// hour of recorded demand as fast as the CPU allows.
+class TraceReplay : public VehicleSource {
+private:
+    enum { BATCH_RECORDS = 4096 };
+
+    VehicleRecordReader reader;
+    std::vector<VehicleRecord> batch;
+    size_t batchPosition;
+    uint64_t currentNs;
+    bool exhausted;
+    long long replayedCount;
+
+    void refill();
+
+public:
+    TraceReplay();
+
+    // Fails unless the file is a trace (simulated time base)
+    bool open(const std::string& filename);
+
+    void advanceTo(double simSeconds);
+    double nextArrivalTime() const;
+    int poll(
+        std::vector<Vehicle>& lane_A,
+        std::vector<Vehicle>& lane_B,
+        std::vector<Vehicle>& lane_C,
+        std::vector<Vehicle>& lane_D
+    );
+
+    // True once every record has been handed over
+    bool isFinished() const;
+    long long getReplayedCount() const;
+};
+
+#endif
@@ -1,13 +1,152 @@
 #include "TrafficGenerator.h"
+#include "ShmChannel.h"
+#include "LaneLog.h"
 #include <iostream>
+#include <string>
+#include <cstdlib>
+#include <csignal>
+#include <chrono>
+
+static TrafficGenerator* activeGenerator = nullptr;
+static ShmChannel* activeChannel = nullptr;
+
+// Ctrl+C stops generating cleanly so the summary still gets printed
+static void onInterrupt(int) {
+    if (activeGenerator) activeGenerator->requestStop();
+    if (activeChannel) activeChannel->stopWaiting();
+}
+
+static void printUsage() {
+    std::cout << "Usage: generator [options]\n"
+              << "  --shm <name>          publish to a shared memory channel instead of lane files\n"
+              << "  --capacity <n>        ring slots when creating the channel (default 65536)\n"
+              << "  --log <dir>           append to segmented lane logs in dir instead of lane files\n"
+              << "  --segment-size <n>    bytes per log segment before rotating (default 4 MiB)\n"
+              << "  --wait <min>,<max>    seconds between vehicles (default 0.5,2; 0,0 = flat out)\n"
+              << "  --binary              write binary lane_X.bin records instead of text\n"
+              << "  --rate <v/s>          rate mode: Poisson arrivals at this total rate, split\n"
+              << "                        40/20/20/20 over roads A-D like the paced mode\n"
+              << "  --road-rates <a,b,c,d> rate mode with a rate per road (vehicles/s)\n"
+              << "  --summary <s>         seconds between rate mode summary lines (default 1)\n"
+              << "  --count <n>           stop after n vehicles\n"
+              << "  --seed <n>            repeatable vehicles (default: seeded from the time)\n"
+              << "  --quiet               no per-vehicle output\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string shmName;
+    size_t capacity = 65536;
+    std::string logDirectory;
+    long long segmentSize = 4 * 1024 * 1024;
+    double minWait = 0.5;
+    double maxWait = 2.0;
+    long long count = 0;
+    bool quiet = false;
+    bool binaryFiles = false;
+    double roadRates[4] = {0.0, 0.0, 0.0, 0.0};
+    double summaryInterval = 1.0;
+    bool seeded = false;
+    unsigned seed = 0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (arg == "--shm" && hasValue) shmName = argv[++i];
+        else if (arg == "--capacity" && hasValue) capacity = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--log" && hasValue) logDirectory = argv[++i];
+        else if (arg == "--segment-size" && hasValue) segmentSize = std::atoll(argv[++i]);
+        else if (arg == "--wait" && hasValue) {
+            if (!TrafficGenerator::parsePacing(argv[++i], minWait, maxWait)) {
+                std::cerr << "--wait needs 0 <= min <= max" << std::endl;
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--count" && hasValue) count = std::atoll(argv[++i]);
+        else if (arg == "--seed" && hasValue) {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+            seeded = true;
+        }
+        else if (arg == "--quiet") quiet = true;
+        else if (arg == "--binary") binaryFiles = true;
+        else if (arg == "--rate" && hasValue) {
+            double total = std::atof(argv[++i]);
+            roadRates[0] = total * 0.4;
+            roadRates[1] = roadRates[2] = roadRates[3] = total * 0.2;
+        }
+        else if (arg == "--road-rates" && hasValue) {
+            std::string list = argv[++i];
+            size_t begin = 0;
+            for (int road = 0; road < 4; road++) {
+                size_t comma = list.find(',', begin);
+                roadRates[road] = std::atof(list.substr(begin, comma - begin).c_str());
+                if (comma == std::string::npos) break;
+                begin = comma + 1;
+            }
+        }
+        else if (arg == "--summary" && hasValue) summaryInterval = std::atof(argv[++i]);
+        else {
+            printUsage();
+            return 1;
+        }
+    }
 
-int main() {
     TrafficGenerator generator;
+    generator.setPacing(minWait, maxWait);
+    generator.setLimit(count);
+    generator.setQuiet(quiet);
+    generator.setFileFormat(binaryFiles ? LANE_FORMAT_BINARY : LANE_FORMAT_TEXT);
+    generator.setRoadRates(roadRates[0], roadRates[1], roadRates[2], roadRates[3]);
+    generator.setSummaryInterval(summaryInterval);
+    if (seeded) {
+        generator.setSeed(seed);
+    }
+
+    ShmChannel channel;
+    if (!shmName.empty()) {
+        if (!channel.open(shmName, capacity)) {
+            return 1;
+        }
+        generator.setSink(&channel);
+        std::cout << "Publishing to shared memory channel " << shmName
+                  << " from sequence " << channel.getWriteSequence() << std::endl;
+    }
+
+    LaneLogWriter laneLog(segmentSize);
+    if (!logDirectory.empty() && shmName.empty()) {
+        if (!laneLog.open(logDirectory)) {
+            return 1;
+        }
+        generator.setSink(&laneLog);
+        std::cout << "Appending to lane logs in " << logDirectory << std::endl;
+    }
+
+    activeGenerator = &generator;
+    activeChannel = &channel;
+    std::signal(SIGINT, onInterrupt);
     
     std::cout << "\nStarting continuous generation...\n" << std::endl;
     
-  
+    auto start = std::chrono::steady_clock::now();
     generator.run();
+    double seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start
+    ).count() / 1000000.0;
+
+    std::cout << "\nGenerated " << generator.getGeneratedCount() << " vehicles in "
+              << seconds << " s";
+    if (seconds > 0.0) {
+        std::cout << " (" << generator.getGeneratedCount() / seconds << " vehicles/s)";
+    }
+    std::cout << std::endl;
+
+    if (channel.isOpen()) {
+        channel.printProducerStats();
+    }
+    if (!logDirectory.empty() && shmName.empty()) {
+        std::cout << "Log segments rotated: " << laneLog.getRotations() << std::endl;
+    }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,487 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cstdlib>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include "TrafficManager.h"
+#include "SimulationClock.h"
+#include "EventClock.h"
+#include "GridNetwork.h"
+#include "TrafficGenerator.h"
+#include "InProcessFeed.h"
+#include "ShmChannel.h"
+#include "LaneLog.h"
+#include "VehicleTrace.h"
+#include "TrafficMetrics.h"
+
+// Headless batch runner: steps the simulation on a simulated clock with a
+// fixed timestep, no SDL and no sleeping, so an hour of traffic takes as long
+// as the CPU needs rather than an hour.
+
+static void printUsage() {
+    std::cout << "Usage: simulator_headless [options]\n"
+              << "  --duration <s>        simulated seconds to run (default 3600, or to the end\n"
+              << "                        of the trace with --replay)\n"
+              << "  --dt <s>              fixed timestep (default 1/60)\n"
+              << "  --events              jump from event to event instead of fixed timesteps\n"
+              << "  --cycle <s>           light cycle interval (default 5)\n"
+              << "  --actuated            actuated lights: gap-out / max-out greens, skip empty roads\n"
+              << "  --min-green <s>       actuated minimum green (default 5)\n"
+              << "  --max-green <s>       actuated maximum green (default 30)\n"
+              << "  --gap <s>             actuated passage time before a gap-out (default 3)\n"
+              << "  --platoon             fixed cycles discharge the whole queue on green, not one car\n"
+              << "  --headway <s>         saturation headway between discharging cars (default 2)\n"
+              << "  --lost-time <s>       start-up lost time before the first car leaves (default 2)\n"
+              << "  --load-interval <s>   lane file poll interval (default 0.5)\n"
+              << "  --spawn-interval <s>  spawn interval (default 0.1)\n"
+              << "  --max-active <n>      vehicles animated at once per road (default 15)\n"
+              << "  --binary              read binary lane_X.bin records instead of lane_X.txt\n"
+              << "  --verbose             keep per-vehicle and per-cycle logging\n"
+              << "\nArrival traces (exactly repeatable demand):\n"
+              << "  --record <file>       write every vehicle taken in, with its simulated arrival time\n"
+              << "  --replay <file>       feed a recorded trace on the simulated clock instead of the lane files\n"
+              << "\nSnapshots (warm up once, fork many runs):\n"
+              << "  --load-snapshot <file> start from a saved state instead of empty roads\n"
+              << "  --save-snapshot <file> save the final state\n"
+              << "\nMetrics export (per road and lane: flow counters, latency p50/p95/p99/max):\n"
+              << "  --metrics-prom <file> rewrite a Prometheus text file every interval\n"
+              << "  --metrics-csv <file>  append CSV rows every interval\n"
+              << "  --metrics-interval <s> simulated seconds between exports (default 10)\n"
+              << "\nIn-process generator (instead of polling the lane files):\n"
+              << "  --inproc-generator    run TrafficGenerator on a thread in this process\n"
+              << "  --gen-wait <min>,<max> wall seconds between vehicles (default 0.5,2; 0,0 = flat out)\n"
+              << "  --ring-capacity <n>   ring slots per road (default 4096)\n"
+              << "  --seed <n>            seed the generator (vehicles still arrive on wall time)\n"
+              << "\nShared memory channel (fed by generator --shm <name>):\n"
+              << "  --shm <name>          poll the channel every step instead of the lane files\n"
+              << "\nSegmented lane logs (written by generator --log <dir>):\n"
+              << "  --log <dir>           follow the logs every step instead of the lane files\n"
+              << "\nGrid mode (no lane files, arrivals generated at the grid edges):\n"
+              << "  --grid <rows>x<cols>  simulate a grid of junctions\n"
+              << "  --threads <n>         worker threads (default: one per core)\n"
+              << "  --arrival-rate <v/s>  arrivals per boundary approach (default 0.2)\n"
+              << "  --seed <n>            seed for arrivals and turning lanes (default 1)\n";
+}
+
+static double wallSecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start
+    ).count() / 1000000.0;
+}
+
+static void printRate(double simSeconds, double wallSeconds, long long steps) {
+    std::cout << "Wall time:        " << wallSeconds << " s" << std::endl;
+    if (wallSeconds > 0.0) {
+        std::cout << "Sim s / wall s:   " << simSeconds / wallSeconds << std::endl;
+        std::cout << "Steps / wall s:   " << steps / wallSeconds << std::endl;
+    }
+}
+
+// Lane-2 capacity per road: saturation flow over the green with somebody
+// waiting, and the flow actually achieved. Every moment is green for one
+// road, so the green times add up to the simulated time, including any run
+// that led up to a restored snapshot.
+static void printDischarge(const TrafficManager& manager) {
+    const char roads[] = {'A', 'B', 'C', 'D'};
+    double simSeconds = 0.0;
+    for (char road : roads) {
+        simSeconds += manager.getDischargeStats(road).greenSeconds;
+    }
+
+    std::cout << "\n--- Stop-line discharge (lane 2) ---" << std::endl;
+    std::cout << "Road  released   green s  queued green s  veh/h queued green  veh/h" << std::endl;
+
+    std::ios::fmtflags oldFlags = std::cout.flags();
+    std::streamsize oldPrecision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(1);
+
+    for (char road : roads) {
+        const DischargeStats& stats = manager.getDischargeStats(road);
+        double saturationFlow = stats.queuedGreenSeconds > 0.0
+            ? stats.released / stats.queuedGreenSeconds * 3600.0 : 0.0;
+        double flow = simSeconds > 0.0 ? stats.released / simSeconds * 3600.0 : 0.0;
+        std::cout << "   " << road
+                  << std::setw(10) << stats.released
+                  << std::setw(10) << stats.greenSeconds
+                  << std::setw(16) << stats.queuedGreenSeconds
+                  << std::setw(20) << saturationFlow
+                  << std::setw(7) << flow << std::endl;
+    }
+
+    std::cout.flags(oldFlags);
+    std::cout.precision(oldPrecision);
+}
+
+// Per-lane latencies of the run (simulated seconds, bucket resolution)
+static void printLatency(const TrafficMetrics& metrics) {
+    const char roads[] = {'A', 'B', 'C', 'D'};
+
+    std::cout << "\n--- Lane latency (s) ---" << std::endl;
+    std::cout << "Road Lane  arrived  exited    stop p50     p95     p99  system p50     p95     p99     max"
+              << std::endl;
+
+    std::ios::fmtflags oldFlags = std::cout.flags();
+    std::streamsize oldPrecision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(1);
+
+    for (char road : roads) {
+        for (int lane = 1; lane <= 3; lane++) {
+            const LaneMetrics& lm = metrics.at(road, lane);
+            std::cout << "   " << road << "    " << lane
+                      << std::setw(9) << lm.arrived
+                      << std::setw(8) << lm.exited
+                      << std::setw(12) << lm.stopDelay.percentile(0.5)
+                      << std::setw(8) << lm.stopDelay.percentile(0.95)
+                      << std::setw(8) << lm.stopDelay.percentile(0.99)
+                      << std::setw(12) << lm.systemTime.percentile(0.5)
+                      << std::setw(8) << lm.systemTime.percentile(0.95)
+                      << std::setw(8) << lm.systemTime.percentile(0.99)
+                      << std::setw(8) << lm.systemTime.getMax() << std::endl;
+        }
+    }
+
+    std::cout.flags(oldFlags);
+    std::cout.precision(oldPrecision);
+}
+
+static int runGrid(int rows, int cols, int threads, double arrivalRate, unsigned seed,
+                   int maxActive, double duration, double dt,
+                   double cycleInterval, double spawnInterval,
+                   SignalControl signalControl, const ActuatedTiming& timing,
+                   DischargeMode dischargeMode, const DischargeTiming& discharge) {
+    GridNetwork grid(rows, cols, threads, arrivalRate, seed, cycleInterval, spawnInterval);
+    grid.setMaxActivePerRoad(maxActive);
+    grid.setSignalControl(signalControl, timing);
+    grid.setDischarge(dischargeMode, discharge);
+
+    long long steps = static_cast<long long>(duration / dt + 0.5);
+
+    std::cout << "Grid run: " << rows << "x" << cols << " junctions on "
+              << grid.getThreadCount() << " thread(s), " << duration
+              << " s simulated, dt = " << dt << " s (" << steps << " steps)" << std::endl;
+
+    auto wallStart = std::chrono::steady_clock::now();
+
+    for (long long i = 0; i < steps; i++) {
+        grid.step(static_cast<float>(dt));
+    }
+
+    double wallSeconds = wallSecondsSince(wallStart);
+
+    std::cout << "\n--- Network ---" << std::endl;
+    std::cout << "Arrivals injected: " << grid.getInjectedCount() << std::endl;
+    std::cout << "Handed off:        " << grid.getHandedOffCount() << std::endl;
+    std::cout << "Left the network:  " << grid.getLeftNetworkCount() << std::endl;
+    std::cout << "Still in network:  " << grid.getVehiclesInNetwork() << std::endl;
+    std::cout << "Released at lights: " << grid.getTotalProcessed() << std::endl;
+
+    std::cout << "\nSimulated time:   " << steps * dt << " s" << std::endl;
+    printRate(steps * dt, wallSeconds, steps);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    double duration = 3600.0;
+    bool durationGiven = false;
+    double dt = 1.0 / 60.0;
+    bool eventDriven = false;
+    double cycleInterval = 5.0;
+    double loadInterval = 0.5;
+    double spawnInterval = 0.1;
+    int maxActive = 15;
+    bool verbose = false;
+    bool binaryFiles = false;
+    bool actuated = false;
+    ActuatedTiming timing;
+    bool platoon = false;
+    DischargeTiming discharge;
+    int gridRows = 0;
+    int gridCols = 0;
+    int threads = 0;
+    double arrivalRate = 0.2;
+    unsigned seed = 1;
+    bool seedGiven = false;
+    bool inprocGenerator = false;
+    double genMinWait = 0.5;
+    double genMaxWait = 2.0;
+    int ringCapacity = 4096;
+    std::string shmName;
+    std::string logDirectory;
+    std::string recordPath;
+    std::string replayPath;
+    std::string loadSnapshotPath;
+    std::string saveSnapshotPath;
+    std::string metricsPromPath;
+    std::string metricsCsvPath;
+    double metricsInterval = 10.0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+
+        if (arg == "--duration" && hasValue) {
+            duration = std::atof(argv[++i]);
+            durationGiven = true;
+        }
+        else if (arg == "--dt" && hasValue) dt = std::atof(argv[++i]);
+        else if (arg == "--events") eventDriven = true;
+        else if (arg == "--cycle" && hasValue) cycleInterval = std::atof(argv[++i]);
+        else if (arg == "--load-interval" && hasValue) loadInterval = std::atof(argv[++i]);
+        else if (arg == "--spawn-interval" && hasValue) spawnInterval = std::atof(argv[++i]);
+        else if (arg == "--max-active" && hasValue) maxActive = std::atoi(argv[++i]);
+        else if (arg == "--actuated") actuated = true;
+        else if (arg == "--min-green" && hasValue) timing.minGreen = std::atof(argv[++i]);
+        else if (arg == "--max-green" && hasValue) timing.maxGreen = std::atof(argv[++i]);
+        else if (arg == "--gap" && hasValue) timing.passageTime = std::atof(argv[++i]);
+        else if (arg == "--platoon") platoon = true;
+        else if (arg == "--headway" && hasValue) discharge.saturationHeadway = std::atof(argv[++i]);
+        else if (arg == "--lost-time" && hasValue) discharge.startupLostTime = std::atof(argv[++i]);
+        else if (arg == "--verbose") verbose = true;
+        else if (arg == "--binary") binaryFiles = true;
+        else if (arg == "--grid" && hasValue) {
+            std::string size = argv[++i];
+            size_t x = size.find('x');
+            if (x == std::string::npos) {
+                printUsage();
+                return 1;
+            }
+            gridRows = std::atoi(size.substr(0, x).c_str());
+            gridCols = std::atoi(size.substr(x + 1).c_str());
+        }
+        else if (arg == "--threads" && hasValue) threads = std::atoi(argv[++i]);
+        else if (arg == "--arrival-rate" && hasValue) arrivalRate = std::atof(argv[++i]);
+        else if (arg == "--seed" && hasValue) {
+            seed = std::strtoul(argv[++i], nullptr, 10);
+            seedGiven = true;
+        }
+        else if (arg == "--inproc-generator") inprocGenerator = true;
+        else if (arg == "--gen-wait" && hasValue) {
+            if (!TrafficGenerator::parsePacing(argv[++i], genMinWait, genMaxWait)) {
+                std::cerr << "--gen-wait needs 0 <= min <= max" << std::endl;
+                printUsage();
+                return 1;
+            }
+        }
+        else if (arg == "--ring-capacity" && hasValue) ringCapacity = std::atoi(argv[++i]);
+        else if (arg == "--shm" && hasValue) shmName = argv[++i];
+        else if (arg == "--log" && hasValue) logDirectory = argv[++i];
+        else if (arg == "--record" && hasValue) recordPath = argv[++i];
+        else if (arg == "--replay" && hasValue) replayPath = argv[++i];
+        else if (arg == "--load-snapshot" && hasValue) loadSnapshotPath = argv[++i];
+        else if (arg == "--save-snapshot" && hasValue) saveSnapshotPath = argv[++i];
+        else if (arg == "--metrics-prom" && hasValue) metricsPromPath = argv[++i];
+        else if (arg == "--metrics-csv" && hasValue) metricsCsvPath = argv[++i];
+        else if (arg == "--metrics-interval" && hasValue) metricsInterval = std::atof(argv[++i]);
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (duration <= 0.0 || dt <= 0.0) {
+        std::cerr << "Duration and timestep must be positive" << std::endl;
+        return 1;
+    }
+
+    if (inprocGenerator + !shmName.empty() + !logDirectory.empty() + !replayPath.empty() > 1) {
+        std::cerr << "Use only one of --inproc-generator, --shm, --log and --replay" << std::endl;
+        return 1;
+    }
+
+    if (gridRows > 0 && gridCols > 0) {
+        return runGrid(gridRows, gridCols, threads, arrivalRate, seed, maxActive,
+                       duration, dt, cycleInterval, spawnInterval,
+                       actuated ? SIGNAL_ACTUATED : SIGNAL_FIXED, timing,
+                       platoon ? DISCHARGE_PLATOON : DISCHARGE_SINGLE, discharge);
+    }
+
+    TrafficManager manager;
+    manager.setVerbose(verbose);
+    manager.setMaxActivePerRoad(maxActive);
+    manager.setSignalControl(actuated ? SIGNAL_ACTUATED : SIGNAL_FIXED, timing);
+    manager.setDischarge(platoon ? DISCHARGE_PLATOON : DISCHARGE_SINGLE, discharge);
+    manager.setLaneFileFormat(binaryFiles ? LANE_FORMAT_BINARY : LANE_FORMAT_TEXT);
+    if (!loadSnapshotPath.empty()) {
+        auto loadStart = std::chrono::steady_clock::now();
+        if (!manager.loadSnapshot(loadSnapshotPath)) {
+            return 1;
+        }
+        std::cout << "Restored " << loadSnapshotPath << " in "
+                  << wallSecondsSince(loadStart) * 1000.0 << " ms" << std::endl;
+    }
+    SimulationClock clock(loadInterval, spawnInterval, cycleInterval);
+    clock.resumeAt(manager.getSimTime());
+    EventClock eventClock(loadInterval, spawnInterval, cycleInterval);
+    eventClock.resumeAt(manager.getSimTime());
+    VehicleSource* source = nullptr;
+
+    InProcessFeed feed(ringCapacity > 0 ? ringCapacity : 1);
+    TrafficGenerator generator;
+    std::thread generatorThread;
+    if (inprocGenerator) {
+        generator.setSink(&feed);
+        generator.setQuiet(!verbose);
+        generator.setPacing(genMinWait, genMaxWait);
+        if (seedGiven) {
+            generator.setSeed(seed);
+        }
+        source = &feed;
+    }
+
+    ShmChannel channel;
+    if (!shmName.empty()) {
+        if (!channel.open(shmName)) {
+            return 1;
+        }
+        source = &channel;
+    }
+
+    LaneLogReader laneLog;
+    if (!logDirectory.empty()) {
+        if (!laneLog.open(logDirectory)) {
+            return 1;
+        }
+        source = &laneLog;
+    }
+
+    TraceReplay replay;
+    if (!replayPath.empty()) {
+        if (!replay.open(replayPath)) {
+            return 1;
+        }
+        source = &replay;
+    }
+
+    clock.setSource(source);
+    eventClock.setSource(source);
+
+    TraceRecorder recorder;
+    if (!recordPath.empty()) {
+        if (!recorder.open(recordPath)) {
+            return 1;
+        }
+        manager.setTraceRecorder(&recorder);
+    }
+
+    MetricsExporter exporter;
+    if (!metricsPromPath.empty() || !metricsCsvPath.empty()) {
+        if (!exporter.open(metricsPromPath, metricsCsvPath, metricsInterval)) {
+            return 1;
+        }
+    }
+    bool exporting = exporter.isOpen();
+
+    // Started only once everything above has opened: an early return with
+    // the thread still joinable would terminate the process
+    if (inprocGenerator) {
+        generatorThread = std::thread(&TrafficGenerator::run, &generator);
+    }
+
+    // A replay without --duration runs until the last recorded arrival
+    bool untilTraceEnds = !replayPath.empty() && !durationGiven;
+    long long steps = static_cast<long long>(duration / dt + 0.5);
+
+    std::cout << "Headless run: ";
+    if (untilTraceEnds) {
+        std::cout << "until the trace ends, ";
+    } else {
+        std::cout << duration << " s simulated, ";
+    }
+    if (eventDriven) {
+        std::cout << "event-driven (";
+    } else if (untilTraceEnds) {
+        std::cout << "dt = " << dt << " s (";
+    } else {
+        std::cout << "dt = " << dt << " s (" << steps << " steps, ";
+    }
+    std::cout << kinematicsKernelName()
+              << " kinematics" << (actuated ? ", actuated lights" : "")
+              << (platoon && !actuated ? ", platoon discharge" : "")
+              << (inprocGenerator ? ", in-process generator" : "")
+              << (channel.isOpen() ? ", shared memory channel" : "")
+              << (logDirectory.empty() ? "" : ", lane logs")
+              << (replayPath.empty() ? "" : ", trace replay")
+              << ")" << std::endl;
+
+    double startTime = manager.getSimTime();
+    auto wallStart = std::chrono::steady_clock::now();
+
+    if (eventDriven) {
+        // Jump from arrival to arrival when replaying to the end; stop at
+        // every export time so the exports land where stepping puts them
+        double endTime = startTime + duration;
+        while (untilTraceEnds ? !replay.isFinished() : eventClock.getSimTime() < endTime) {
+            double until = untilTraceEnds ? replay.nextArrivalTime() : endTime;
+            if (exporting) {
+                until = std::min(until, exporter.getNextExportTime());
+            }
+            eventClock.advanceTo(manager, until);
+            if (exporting) exporter.update(manager.getMetrics(), eventClock.getSimTime());
+        }
+        steps = eventClock.getStepCount();
+    }
+    else if (untilTraceEnds) {
+        steps = 0;
+        while (!replay.isFinished()) {
+            clock.step(manager, static_cast<float>(dt));
+            steps++;
+            if (exporting) exporter.update(manager.getMetrics(), clock.getSimTime());
+        }
+    }
+    else {
+        for (long long i = 0; i < steps; i++) {
+            clock.step(manager, static_cast<float>(dt));
+            if (exporting) exporter.update(manager.getMetrics(), clock.getSimTime());
+        }
+    }
+
+    double wallSeconds = wallSecondsSince(wallStart);
+
+    if (inprocGenerator) {
+        generator.requestStop();
+        feed.close();
+        generatorThread.join();
+        feed.printStats();
+    }
+    if (channel.isOpen()) {
+        channel.printConsumerStats();
+    }
+    if (!logDirectory.empty()) {
+        laneLog.printStats();
+    }
+    if (!replayPath.empty()) {
+        std::cout << "\nReplayed " << replay.getReplayedCount() << " vehicles from " << replayPath
+                  << (replay.isFinished() ? "" : " (trace not finished)") << std::endl;
+    }
+    if (eventDriven) {
+        eventClock.printStats();
+    }
+    if (recorder.isOpen()) {
+        recorder.close();
+        std::cout << "\nRecorded " << recorder.getRecordedCount() << " arrivals to " << recordPath << std::endl;
+    }
+
+    std::cout << "\n--- Final State ---" << std::endl;
+    manager.display();
+    printDischarge(manager);
+    printLatency(manager.getMetrics());
+
+    double simTime = eventDriven ? eventClock.getSimTime() : clock.getSimTime();
+    if (exporting) {
+        exporter.exportNow(manager.getMetrics(), simTime);
+        std::cout << "\nExported metrics " << exporter.getExportCount() << " time(s)" << std::endl;
+    }
+
+    if (!saveSnapshotPath.empty() && manager.saveSnapshot(saveSnapshotPath)) {
+        std::cout << "\nSaved the final state to " << saveSnapshotPath << std::endl;
+    }
+
+    int cycles = eventDriven ? eventClock.getCycleCount() : clock.getCycleCount();
+    std::cout << "\nSimulated time:   " << simTime << " s" << std::endl;
+    std::cout << (actuated ? "Green changes:    " : "Light cycles:     ") << cycles << std::endl;
+    printRate(eventDriven ? simTime - startTime : steps * dt, wallSeconds, steps);
+
+    return 0;
+}
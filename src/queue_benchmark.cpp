@@ -0,0 +1,169 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <chrono>
+#include <stdexcept>
+#include "Queue.h"
+#include "Vehicle.h"
+
+// Compares the ring-buffer Queue<T> against the original node-per-element
+// linked list it replaced. Each run fills a queue with N vehicles, drains it,
+// then churns N dequeue/enqueue pairs at a steady backlog of N/2.
+//
+// Usage: queue_benchmark [N ...]   (default 1e3 1e5 1e7)
+
+// The previous Queue<T> implementation, kept here only as the baseline
+template <typename T>
+class LinkedQueue {
+private:
+     struct Node {
+          T data;
+          Node* next;
+          Node(T value) : data(value), next(nullptr) {}
+     };
+     Node* frontptr;
+     Node* backptr;
+     int count;
+public:
+     LinkedQueue() : frontptr(nullptr), backptr(nullptr), count(0) {}
+     ~LinkedQueue() {
+          while (!isEmpty()) {
+               dequeue();
+          }
+     }
+
+     void enqueue(T item) {
+          Node* newNode = new Node(item);
+          if (isEmpty()) {
+               frontptr = newNode;
+               backptr = newNode;
+          } else {
+               backptr->next = newNode;
+               backptr = newNode;
+          }
+          count++;
+     }
+
+     T dequeue() {
+          if (isEmpty()) {
+               throw std::runtime_error("Queue is empty! Cannot dequeue.");
+          }
+          Node* temp = frontptr;
+          T data = temp->data;
+          frontptr = frontptr->next;
+          if (frontptr == nullptr) {
+               backptr = nullptr;
+          }
+          delete temp;
+          count--;
+          return data;
+     }
+
+     bool isEmpty() const { return frontptr == nullptr; }
+     int getSize() const { return count; }
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start
+    ).count() / 1000000.0;
+}
+
+static std::vector<Vehicle> makeVehicles(int n) {
+    char roads[] = {'A', 'B', 'C', 'D'};
+    std::vector<Vehicle> vehicles;
+    vehicles.reserve(n);
+    for (int i = 0; i < n; i++) {
+        vehicles.push_back(Vehicle("BA3CHA" + std::to_string(i % 10000), roads[i % 4], (i % 3) + 1));
+    }
+    return vehicles;
+}
+
+struct BenchResult {
+    double fill;
+    double drain;
+    double churn;
+    long long checksum;
+};
+
+// Vehicles are built up front so only queue work is timed. Fill copies from
+// the source for both queues; drain and churn use whatever each API offers
+// (the linked list can only copy, the ring buffer moves).
+template <typename Q>
+static BenchResult runBench(const std::vector<Vehicle>& source) {
+    BenchResult r = {0, 0, 0, 0};
+    int n = static_cast<int>(source.size());
+    Q queue;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        queue.enqueue(source[i]);
+    }
+    r.fill = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    while (!queue.isEmpty()) {
+        Vehicle v = queue.dequeue();
+        r.checksum += v.getLaneNumber();
+    }
+    r.drain = secondsSince(start);
+
+    for (int i = 0; i < n / 2; i++) {
+        queue.enqueue(source[i]);
+    }
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) {
+        // Rotate the backlog: the vehicle at the front rejoins at the back
+        queue.enqueue(queue.dequeue());
+    }
+    r.churn = secondsSince(start);
+    r.checksum += queue.getSize();
+    return r;
+}
+
+static void printRow(const std::string& name, int n, const BenchResult& r) {
+    double perOp = 1e9 / n;
+    std::cout << std::left << std::setw(8) << name
+              << std::right << std::setw(10) << n
+              << std::fixed << std::setprecision(1)
+              << std::setw(12) << r.fill * perOp
+              << std::setw(12) << r.drain * perOp
+              << std::setw(12) << r.churn * perOp
+              << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<int> sizes;
+    for (int i = 1; i < argc; i++) {
+        sizes.push_back(static_cast<int>(std::atof(argv[i])));
+    }
+    if (sizes.empty()) {
+        sizes.push_back(1000);
+        sizes.push_back(100000);
+        sizes.push_back(10000000);
+    }
+
+    std::cout << "Queue<Vehicle> benchmark, ns per operation\n" << std::endl;
+    std::cout << std::left << std::setw(8) << "queue"
+              << std::right << std::setw(10) << "N"
+              << std::setw(12) << "fill"
+              << std::setw(12) << "drain"
+              << std::setw(12) << "churn" << std::endl;
+
+    for (int n : sizes) {
+        if (n <= 0) continue;
+        std::vector<Vehicle> source = makeVehicles(n);
+        BenchResult linked = runBench<LinkedQueue<Vehicle> >(source);
+        BenchResult ring = runBench<Queue<Vehicle> >(source);
+        printRow("linked", n, linked);
+        printRow("ring", n, ring);
+        if (linked.checksum != ring.checksum) {
+            std::cerr << "Checksum mismatch at N = " << n << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
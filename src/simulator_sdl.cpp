@@ -4,18 +4,159 @@
 #include "SDLRenderer.h"
 #include "TrafficManager.h"
 #include "Vehicle.h"
+#include "TrafficGenerator.h"
+#include "InProcessFeed.h"
+#include "ShmChannel.h"
+#include "LaneLog.h"
+#include "VehicleTrace.h"
+#include "TrafficMetrics.h"
+#include "FrameProfiler.h"
+#include "SimulationClock.h"
+#include "SimulationThread.h"
+#include "FrameCapture.h"
+#include <string>
+#include <cstdlib>
 #include <thread>
 #include <chrono>
 
-int main() {
+int main(int argc, char* argv[]) {
+    // --inproc-generator runs the generator on a thread in this process and
+    // hands vehicles over through in-memory rings instead of the lane files;
+    // --shm <name> takes them from a generator process through shared memory;
+    // --binary reads lane_X.bin records written by generator --binary;
+    // --log <dir> follows the segmented lane logs of generator --log <dir>;
+    // --record <file> writes every arrival with its simulated time, for
+    // simulator_headless --replay <file>; --actuated switches the lights to
+    // actuated control (green held while cars discharge, empty roads skipped);
+    // --platoon lets fixed cycles discharge the whole queue on green;
+    // --metrics-prom <file> / --metrics-csv <file> export per-lane flow and
+    // latency every 10 simulated seconds; --profile times every frame phase,
+    // draws the figures over the scene (P toggles) and prints them on exit;
+    // --single-thread steps the simulation in the drawing loop itself, with
+    // the frame time as its timestep, instead of on its own fixed-step thread;
+    // --offscreen draws into memory with the software renderer (no display
+    // or GPU needed) for --frames N frames (default 3600); --capture <prefix>
+    // writes every frame, or every --capture-every N-th, to <prefix>NNNNNN.ppm
+    // on a background thread, dropping frames rather than waiting for the disk;
+    // --zoom Z starts the camera at that zoom (arrows/drag pan, wheel zooms);
+    // --lod sums up the vehicles that are not drawn as one bar per lane
+    bool inprocGenerator = false;
+    bool actuated = false;
+    bool platoon = false;
+    bool binaryFiles = false;
+    std::string shmName;
+    std::string logDirectory;
+    std::string recordPath;
+    std::string metricsPromPath;
+    std::string metricsCsvPath;
+    bool profile = false;
+    bool singleThread = false;
+    bool offscreen = false;
+    long long maxFrames = 0;
+    std::string capturePrefix;
+    int captureEvery = 1;
+    float zoom = 1.0f;
+    bool lod = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--inproc-generator") {
+            inprocGenerator = true;
+        }
+        else if (arg == "--binary") {
+            binaryFiles = true;
+        }
+        else if (arg == "--shm" && i + 1 < argc) {
+            shmName = argv[++i];
+        }
+        else if (arg == "--log" && i + 1 < argc) {
+            logDirectory = argv[++i];
+        }
+        else if (arg == "--actuated") {
+            actuated = true;
+        }
+        else if (arg == "--platoon") {
+            platoon = true;
+        }
+        else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        }
+        else if (arg == "--metrics-prom" && i + 1 < argc) {
+            metricsPromPath = argv[++i];
+        }
+        else if (arg == "--metrics-csv" && i + 1 < argc) {
+            metricsCsvPath = argv[++i];
+        }
+        else if (arg == "--profile") {
+            profile = true;
+        }
+        else if (arg == "--single-thread") {
+            singleThread = true;
+        }
+        else if (arg == "--offscreen") {
+            offscreen = true;
+        }
+        else if (arg == "--frames" && i + 1 < argc) {
+            maxFrames = std::atoll(argv[++i]);
+        }
+        else if (arg == "--capture" && i + 1 < argc) {
+            capturePrefix = argv[++i];
+        }
+        else if (arg == "--capture-every" && i + 1 < argc) {
+            captureEvery = std::atoi(argv[++i]);
+        }
+        else if (arg == "--zoom" && i + 1 < argc) {
+            zoom = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (arg == "--lod") {
+            lod = true;
+        }
+    }
+    
+    ShmChannel channel;
+    if (!shmName.empty() && !inprocGenerator && !channel.open(shmName)) {
+        return 1;
+    }
+    
+    LaneLogReader laneLog;
+    bool useLaneLog = !logDirectory.empty() && !inprocGenerator && !channel.isOpen();
+    if (useLaneLog && !laneLog.open(logDirectory)) {
+        return 1;
+    }
+    
+
     SDLRenderer renderer(900, 700);
-    if (!renderer.init("Traffic Management System - Animated")) {
+    bool initialized = offscreen ? renderer.initOffscreen()
+                                 : renderer.init("Traffic Management System - Animated");
+    if (!initialized) {
         std::cerr << "Failed to initialize SDL!" << std::endl;
         return 1;
     }
+    if (offscreen && maxFrames <= 0) {
+        maxFrames = 3600;
+    }
+    if (zoom > 0.0f && zoom != 1.0f) {
+        renderer.setCamera(450.0f, 350.0f, zoom);
+    }
+    renderer.setQueueBars(lod);
+    
+    FrameCapture capture;
+    if (!capturePrefix.empty()) {
+        capture.setStride(captureEvery);
+        if (!capture.start(capturePrefix, renderer.getWidth(), renderer.getHeight())) {
+            return 1;
+        }
+        renderer.setFrameCapture(&capture);
+    }
     
     std::cout << "✓ SDL initialized successfully!\n";
-    std::cout << "✓ Window created (900x700)\n";
+    if (offscreen) {
+        std::cout << "✓ Drawing offscreen (900x700) for " << maxFrames << " frames\n";
+    } else {
+        std::cout << "✓ Window created (900x700)\n";
+    }
+    if (capture.isRunning()) {
+        std::cout << "✓ Capturing frames to " << capturePrefix << "*.ppm\n";
+    }
     std::cout << "\n🚦 Traffic Rules:\n";
     std::cout << "   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
     std::cout << "   Lane 1 (Right):  🟢 FREE FLOW - Right turns\n";
@@ -23,15 +164,52 @@ int main() {
     std::cout << "   Lane 3 (Left):   🟢 FREE FLOW - Left turns\n";
     std::cout << "   ━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n\n";
     std::cout << "📋 Instructions:\n";
-    std::cout << "   - Run generator_main.exe in another terminal\n";
+    if (inprocGenerator) {
+        std::cout << "   - Generator running in-process (--inproc-generator)\n";
+    } else if (channel.isOpen()) {
+        std::cout << "   - Run generator_main.exe --shm " << shmName << " in another terminal\n";
+    } else if (useLaneLog) {
+        std::cout << "   - Run generator_main.exe --log " << logDirectory << " in another terminal\n";
+    } else {
+        std::cout << "   - Run generator_main.exe in another terminal\n";
+    }
     std::cout << "   - Vehicles in lanes 1 & 3 flow freely (no stops)\n";
     std::cout << "   - Vehicles in lane 2 stop at red lights\n";
     std::cout << "   - Priority mode: Road A > 10 vehicles\n";
-    std::cout << "   - Close window to exit\n\n";
+    if (!offscreen) {
+        std::cout << "   - Arrows/drag pan, wheel or +/- zoom, Home resets, L toggles queue bars\n";
+        std::cout << "   - Close window to exit\n";
+    }
+    std::cout << "\n";
     
     TrafficManager manager;
+    manager.setLaneFileFormat(binaryFiles ? LANE_FORMAT_BINARY : LANE_FORMAT_TEXT);
+    manager.setSignalControl(actuated ? SIGNAL_ACTUATED : SIGNAL_FIXED);
+    manager.setDischarge(platoon ? DISCHARGE_PLATOON : DISCHARGE_SINGLE);
     int cycleCount = 0;
     
+    TraceRecorder recorder;
+    if (!recordPath.empty() && recorder.open(recordPath)) {
+        manager.setTraceRecorder(&recorder);
+        std::cout << "⏺  Recording arrivals to " << recordPath << "\n";
+    }
+    
+    MetricsExporter exporter;
+    if ((!metricsPromPath.empty() || !metricsCsvPath.empty())
+        && exporter.open(metricsPromPath, metricsCsvPath, 10.0)) {
+        std::cout << "📈 Exporting lane metrics every 10 s\n";
+    }
+    double simTime = 0.0;
+    
+    InProcessFeed feed;
+    TrafficGenerator generator;
+    std::thread generatorThread;
+    if (inprocGenerator) {
+        generator.setSink(&feed);
+        generator.setQuiet(true);
+        generatorThread = std::thread(&TrafficGenerator::run, &generator);
+    }
+    
     auto lastCycleTime = std::chrono::steady_clock::now();
     const int CYCLE_INTERVAL_MS = 5000; 
     
@@ -44,12 +222,97 @@ int main() {
     const int TARGET_FPS = 60;
     const int FRAME_TIME_MS = 1000 / TARGET_FPS;
     
-    std::cout << "⏱️  Light cycle: " << CYCLE_INTERVAL_MS / 1000 << " seconds\n";
+    if (actuated) {
+        std::cout << "⏱️  Actuated lights: green extends while cars discharge\n";
+    } else {
+        std::cout << "⏱️  Light cycle: " << CYCLE_INTERVAL_MS / 1000 << " seconds\n";
+    }
     std::cout << "🎮 Simulation running at " << TARGET_FPS << " FPS\n\n";
     
+    FrameProfiler profiler;
+    if (profile) {
+        profiler.setEnabled(true);
+        profiler.setFrameBudget(FRAME_TIME_MS * 1000.0f);
+        renderer.setProfilerOverlay(&profiler);
+        std::cout << "⏲️  Profiling frame phases (P toggles the overlay)\n\n";
+    }
+    
+    // The simulation steps 1/60 s at a time on its own thread whatever the
+    // frame rate; this thread only draws the newest state it published
+    long long simulationSteps = 0;
+    if (!singleThread) {
+        SimulationClock clock(LOAD_INTERVAL_MS / 1000.0, SPAWN_INTERVAL_MS / 1000.0,
+                              CYCLE_INTERVAL_MS / 1000.0);
+        if (inprocGenerator) {
+            clock.setSource(&feed);
+        }
+        else if (channel.isOpen()) {
+            clock.setSource(&channel);
+        }
+        else if (useLaneLog) {
+            clock.setSource(&laneLog);
+        }
+        
+        clock.setPhaseTiming(profile);
+        
+        SimulationThread simulation(manager, clock, 1.0 / TARGET_FPS);
+        if (exporter.isOpen()) {
+            simulation.setStepHook([&exporter](const TrafficManager& m, double t) {
+                exporter.update(m.getMetrics(), t);
+            });
+        }
+        simulation.start();
+        
+        long long frames = 0;
+        while (!renderer.shouldClose() && (maxFrames <= 0 || frames++ < maxFrames)) {
+            auto frameStart = std::chrono::steady_clock::now();
+            renderer.handleEvents();
+            
+            if (simulation.update()) {
+                // The newest step's phases, timed on the simulation thread
+                const RenderState& state = simulation.getState();
+                profiler.addSample(PHASE_LOAD, state.loadMicros);
+                profiler.addSample(PHASE_SPAWN, state.spawnMicros);
+                profiler.addSample(PHASE_UPDATE, state.updateMicros);
+                profiler.addSample(PHASE_SIGNALS, state.signalsMicros);
+                profiler.addSample(PHASE_CLEANUP, state.cleanupMicros);
+                profiler.addSample(PHASE_STEP, state.stepMicros);
+            }
+            {
+                FrameProfiler::Scope timer(profiler, PHASE_RENDER);
+                TrafficManager::renderState(simulation.getState(), renderer);
+            }
+            
+            auto frameEnd = std::chrono::steady_clock::now();
+            auto frameDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
+                frameEnd - frameStart
+            ).count();
+            profiler.addSample(PHASE_FRAME,
+                               std::chrono::duration<float, std::micro>(frameEnd - frameStart).count());
+            profiler.endFrame();
+            
+            if (frameDuration < FRAME_TIME_MS) {
+                std::this_thread::sleep_for(
+                    std::chrono::milliseconds(FRAME_TIME_MS - frameDuration)
+                );
+            }
+        }
+        
+        simulation.stop();
+        simulationSteps = simulation.getStepCount();
+        simTime = clock.getSimTime();
+        cycleCount = clock.getCycleCount();
+        if (simulation.getResyncCount() > 0) {
+            std::cout << "⚠️  Simulation fell behind real time " << simulation.getResyncCount()
+                      << " time(s)\n";
+        }
+    }
+    
     auto lastFrameTime = std::chrono::steady_clock::now();
+    long long frames = 0;
     
-    while (!renderer.shouldClose()) {
+    // --single-thread: the original loop, simulation and drawing in turn
+    while (singleThread && !renderer.shouldClose() && (maxFrames <= 0 || frames++ < maxFrames)) {
         auto frameStart = std::chrono::steady_clock::now();
         auto now = std::chrono::steady_clock::now();
         
@@ -58,6 +321,8 @@ int main() {
         ).count();
         float deltaTime = frameDelta / 1000000.0f; 
         lastFrameTime = now;
+        simTime += deltaTime;
+        manager.setSimTime(simTime);
         
         renderer.handleEvents();
         
@@ -65,9 +330,22 @@ int main() {
             now - lastLoadTime
         ).count();
         
-        if (loadElapsed >= LOAD_INTERVAL_MS) {
-            manager.loadVehiclesFromFiles();
-            lastLoadTime = now;
+        {
+            FrameProfiler::Scope timer(profiler, PHASE_LOAD);
+            // The rings are drained every frame; the files only every interval
+            if (inprocGenerator) {
+                manager.loadVehiclesFrom(feed);
+            }
+            else if (channel.isOpen()) {
+                manager.loadVehiclesFrom(channel);
+            }
+            else if (useLaneLog) {
+                manager.loadVehiclesFrom(laneLog);
+            }
+            else if (loadElapsed >= LOAD_INTERVAL_MS) {
+                manager.loadVehiclesFromFiles();
+                lastLoadTime = now;
+            }
         }
         
         auto spawnElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -75,36 +353,63 @@ int main() {
         ).count();
         
         if (spawnElapsed >= SPAWN_INTERVAL_MS) {
+            FrameProfiler::Scope timer(profiler, PHASE_SPAWN);
             manager.spawnQueuedVehicles();
             lastSpawnTime = now;
         }
         
-        manager.updateVehiclePositions(deltaTime);
+        {
+            FrameProfiler::Scope timer(profiler, PHASE_UPDATE);
+            manager.updateVehiclePositions(deltaTime);
+        }
         
         auto cycleElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
             now - lastCycleTime
         ).count();
         
-        if (cycleElapsed >= CYCLE_INTERVAL_MS) {
-            cycleCount++;
-            
-            std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
-            std::cout << "Cycle #" << cycleCount << " - Switching lights...\n";
-            
-            manager.processCycle();
-            manager.display();
-            
-            lastCycleTime = now;
+        {
+            FrameProfiler::Scope timer(profiler, PHASE_SIGNALS);
+            // Discharges platoons every frame; under actuated control it also
+            // changes the green and logs it itself (the manager is verbose here)
+            bool greenChanged = manager.updateSignals(deltaTime);
+            if (actuated) {
+                if (greenChanged) {
+                    cycleCount++;
+                }
+            }
+            else if (cycleElapsed >= CYCLE_INTERVAL_MS) {
+                cycleCount++;
+                
+                std::cout << "━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n";
+                std::cout << "Cycle #" << cycleCount << " - Switching lights...\n";
+                
+                manager.processCycle();
+                manager.display();
+                
+                lastCycleTime = now;
+            }
         }
         
-        manager.cleanupInactiveVehicles();
+        {
+            FrameProfiler::Scope timer(profiler, PHASE_CLEANUP);
+            manager.cleanupInactiveVehicles();
+            if (exporter.isOpen()) {
+                exporter.update(manager.getMetrics(), simTime);
+            }
+        }
         
-        manager.renderToSDL(renderer);
+        {
+            FrameProfiler::Scope timer(profiler, PHASE_RENDER);
+            manager.renderToSDL(renderer);
+        }
         
         auto frameEnd = std::chrono::steady_clock::now();
         auto frameDuration = std::chrono::duration_cast<std::chrono::milliseconds>(
             frameEnd - frameStart
         ).count();
+        profiler.addSample(PHASE_FRAME,
+                           std::chrono::duration<float, std::micro>(frameEnd - frameStart).count());
+        profiler.endFrame();
         
         if (frameDuration < FRAME_TIME_MS) {
             std::this_thread::sleep_for(
@@ -113,8 +418,40 @@ int main() {
         }
     }
     
+    if (inprocGenerator) {
+        generator.requestStop();
+        feed.close();
+        generatorThread.join();
+        feed.printStats();
+    }
+    if (channel.isOpen()) {
+        channel.printConsumerStats();
+    }
+    if (useLaneLog) {
+        laneLog.printStats();
+    }
+    if (recorder.isOpen()) {
+        recorder.close();
+        std::cout << "Recorded " << recorder.getRecordedCount() << " arrivals to " << recordPath << std::endl;
+    }
+    if (exporter.isOpen()) {
+        exporter.exportNow(manager.getMetrics(), simTime);
+    }
+    if (capture.isRunning()) {
+        capture.stop();
+        capture.printStats();
+    }
+    
+    if (profile) {
+        profiler.report(std::cout);
+    }
+    
     std::cout << "\n\n🏁 Simulation ended. Total vehicles processed: " 
               << manager.getTotalProcessed() << std::endl;
+    if (!singleThread) {
+        std::cout << "   " << simulationSteps << " fixed steps, " << simTime << " s simulated, "
+                  << cycleCount << (actuated ? " green changes" : " light cycles") << std::endl;
+    }
     
     return 0;
 }
\ No newline at end of file